@@ -0,0 +1,212 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file alloc.c
+ * @brief Slab pools and per-process arenas, see alloc.h.
+ */
+
+#include "alloc.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    ALIGNMENT = alignof(max_align_t),
+    POOL_SLAB_BYTES = 64 * 1024,
+    ARENA_FIRST_CHUNK = 4 * 1024,
+    ARENA_MAX_CHUNK = 1024 * 1024,
+};
+
+// header of each pool slab; objects follow, starting on an aligned boundary
+typedef struct pool_slab_t {
+    struct pool_slab_t* next;
+} PoolSlab;
+
+// header of each arena chunk; allocations follow
+typedef struct arena_chunk_t {
+    struct arena_chunk_t* next;
+} ArenaChunk;
+
+static inline size_t Alloc_roundUp(size_t n) {
+    return (n + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+}
+
+static void* Alloc_system(size_t size) {
+    void* p = calloc(1, size);
+    if (p == NULL) {
+        perror("Error allocating memory.");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// every live pool that has allocated at least once, for Alloc_printStats
+static Pool* pools = NULL;
+static pthread_mutex_t poolsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// totals over every arena, updated atomically since arenas of different
+// simulations are used from different threads
+static struct arena_stats_t {
+    unsigned long arenas;   // arenas that allocated at least once
+    unsigned long allocs;   // objects handed out
+    unsigned long chunks;   // system allocations made
+    unsigned long releases; // Arena_release calls that freed something
+    size_t bytes;           // bytes handed out
+    size_t reserved;        // bytes in chunks
+} arenaStats;
+
+// === POOL ===
+
+/** Carves a new slab out of the system for a pool */
+static void Pool_grow(Pool* pool) {
+    if (!pool->registered) {
+        size_t stride = pool->size < sizeof(void*) ? sizeof(void*) : pool->size;
+        pool->stride = Alloc_roundUp(stride);
+        pool->registered = true;
+        pthread_mutex_lock(&poolsLock);
+        pool->next = pools;
+        pools = pool;
+        pthread_mutex_unlock(&poolsLock);
+    }
+
+    size_t bytes = POOL_SLAB_BYTES;
+    size_t header = Alloc_roundUp(sizeof(PoolSlab));
+    if (bytes < header + pool->stride) bytes = header + pool->stride;
+
+    PoolSlab* slab = Alloc_system(bytes);
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->fresh = (char*)slab + header;
+    pool->freshEnd = (char*)slab + bytes;
+    pool->slabCount++;
+}
+
+void* Pool_alloc(Pool* pool) {
+    assert(pool != NULL && pool->size > 0);
+    void* object;
+    if (pool->freeList != NULL) {
+        object = pool->freeList;
+        pool->freeList = *(void**)object;
+    } else {
+        if (pool->fresh == NULL
+            || (size_t)(pool->freshEnd - pool->fresh) < pool->stride) {
+            Pool_grow(pool);
+        }
+        object = pool->fresh;
+        pool->fresh += pool->stride;
+    }
+
+    pool->allocs++;
+    if (++pool->live > pool->peakLive) pool->peakLive = pool->live;
+    return object;
+}
+
+void Pool_free(Pool* pool, void* object) {
+    if (object == NULL) return;
+    assert(pool->live > 0);
+    *(void**)object = pool->freeList;
+    pool->freeList = object;
+    pool->frees++;
+    pool->live--;
+}
+
+void Pool_destroy(Pool* pool) {
+    if (pool->registered) {
+        pthread_mutex_lock(&poolsLock);
+        Pool** link = &pools;
+        while (*link != pool) link = &(*link)->next;
+        *link = pool->next;
+        pthread_mutex_unlock(&poolsLock);
+        pool->registered = false;
+    }
+
+    PoolSlab* slab = pool->slabs;
+    while (slab != NULL) {
+        PoolSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->freeList = NULL;
+    pool->fresh = pool->freshEnd = NULL;
+    pool->live = 0;
+}
+
+// === ARENA ===
+
+/** Adds to an arena counter, from any thread */
+#define Arena_count(COUNTER, N) \
+    __atomic_fetch_add(&arenaStats.COUNTER, (N), __ATOMIC_RELAXED)
+
+void Arena_init(Arena* arena) {
+    arena->chunks = NULL;
+    arena->next = arena->end = NULL;
+    arena->chunkSize = ARENA_FIRST_CHUNK;
+}
+
+void* Arena_alloc(Arena* arena, size_t size) {
+    size = Alloc_roundUp(size);
+    if (arena->next == NULL || (size_t)(arena->end - arena->next) < size) {
+        if (arena->chunks == NULL) Arena_count(arenas, 1);
+
+        // chunks double up to a cap, and oversized requests get their own
+        size_t header = Alloc_roundUp(sizeof(ArenaChunk));
+        size_t bytes = arena->chunkSize;
+        if (bytes < header + size) bytes = header + size;
+        if (arena->chunkSize < ARENA_MAX_CHUNK) arena->chunkSize *= 2;
+
+        ArenaChunk* chunk = Alloc_system(bytes);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->next = (char*)chunk + header;
+        arena->end = (char*)chunk + bytes;
+
+        Arena_count(chunks, 1);
+        Arena_count(reserved, bytes);
+    }
+
+    // chunks come zeroed from calloc and are never reused, so no memset
+    void* p = arena->next;
+    arena->next += size;
+    Arena_count(allocs, 1);
+    Arena_count(bytes, size);
+    return p;
+}
+
+void Arena_release(Arena* arena) {
+    ArenaChunk* chunk = arena->chunks;
+    if (chunk != NULL) Arena_count(releases, 1);
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    Arena_init(arena);
+}
+
+// === STATS ===
+
+void Alloc_printStats() {
+    unsigned long objects = arenaStats.allocs;
+    unsigned long systemAllocs = arenaStats.chunks;
+
+    printf("\x1B[1m\x1B[7m%s\x1B[0m\n", " ALLOCATOR ");
+    pthread_mutex_lock(&poolsLock);
+    for (Pool* p = pools; p != NULL; p = p->next) {
+        printf("  pool %s: %lu allocs, %lu frees, peak %zu live, %lu slabs "
+               "(%zu B objects)\n",
+               p->name, p->allocs, p->frees, p->peakLive, p->slabCount,
+               p->size);
+        objects += p->allocs;
+        systemAllocs += p->slabCount;
+    }
+    pthread_mutex_unlock(&poolsLock);
+    printf("  arenas: %lu, %lu allocs, %zu B used of %zu B in %lu chunks, "
+           "%lu released\n",
+           arenaStats.arenas, arenaStats.allocs, arenaStats.bytes,
+           arenaStats.reserved, arenaStats.chunks, arenaStats.releases);
+    printf("  \x1B[1mtotal:\x1B[0m %lu objects from %lu system allocations\n",
+           objects, systemAllocs);
+}
@@ -0,0 +1,90 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file alloc.h
+ * @brief Two allocators that replace one-malloc-per-object on the hot paths:
+ *  - Pool: a slab pool of fixed-size objects of one type, with a free list.
+ *    Objects are carved out of 64 KB slabs and recycled when freed, so
+ *    malloc is only called once per slab. Used for objects with their own
+ *    lifetimes (processes, pid map nodes).
+ *  - Arena: a bump allocator owned by one process, holding everything that
+ *    lives exactly as long as the process does (virtual pages, interval
+ *    nodes, page table structure). Individual objects are never freed; the
+ *    whole arena is released in one shot when the process finishes.
+ * @details Both keep counters, printed by Alloc_printStats, to measure how
+ * many system allocations they save. A pool or an arena must only be used by
+ * one thread at a time, but different ones can be used concurrently; the
+ * counters they share are updated safely.
+ */
+
+#ifndef _ALLOC_
+#define _ALLOC_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct pool_t {
+    const char* name; // for Alloc_printStats
+    size_t size;      // object size asked for
+    size_t stride;    // object size rounded up for the free list & alignment
+
+    void* freeList;       // freed objects, linked through their first word
+    struct pool_slab_t* slabs; // every slab, newest first
+    char* fresh;          // never-used space left in the newest slab
+    char* freshEnd;
+
+    // counters
+    unsigned long allocs;
+    unsigned long frees;
+    unsigned long slabCount;
+    size_t live;
+    size_t peakLive;
+
+    bool registered;   // linked into the list Alloc_printStats walks
+    struct pool_t* next;
+} Pool;
+
+/** Static initializer for a pool of objects of the given type */
+#define POOL_INITIALIZER(NAME, TYPE) {.name = (NAME), .size = sizeof(TYPE)}
+
+typedef struct arena_t {
+    struct arena_chunk_t* chunks; // newest first
+    char* next;                   // bump pointer into the newest chunk
+    char* end;
+    size_t chunkSize; // size of the next chunk, grows geometrically
+} Arena;
+
+/**
+ * Takes an object from a pool, uninitialized.
+ */
+void* Pool_alloc(Pool* pool);
+
+/**
+ * Returns an object to its pool, to be handed out again by Pool_alloc.
+ */
+void Pool_free(Pool* pool, void* object);
+
+/**
+ * Gives every slab of a pool back to the system. Objects still in use
+ * become invalid, and the pool drops out of Alloc_printStats.
+ */
+void Pool_destroy(Pool* pool);
+
+/** Sets up an empty arena; nothing is allocated until the first use */
+void Arena_init(Arena* arena);
+
+/**
+ * Allocates zeroed memory from an arena, aligned for any type.
+ */
+void* Arena_alloc(Arena* arena, size_t size);
+
+/**
+ * Frees everything allocated from an arena at once, and leaves it empty.
+ */
+void Arena_release(Arena* arena);
+
+/**
+ * Prints allocation counters for every pool used so far and for arenas.
+ */
+void Alloc_printStats();
+
+#endif
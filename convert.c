@@ -0,0 +1,83 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file convert.c
+ * @brief pfsim-convert: turns a text .addrtrace into the packed binary trace
+ * format described in trace_reader.h, which pfsim can read without parsing.
+ */
+
+#include "trace_reader.h"
+
+#include <assert.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** fwrite wrapper, exits with a message on short writes */
+static void safe_fwrite(const void* buf, size_t size, size_t n, FILE* out) {
+    if (fwrite(buf, size, n, out) != n) {
+        perror("Error writing binary trace.");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Converts the trace named by argv[1] into a binary trace at argv[2]
+ * @return EXIT_SUCCESS on success and EXIT_FAILURE on failure
+ */
+int main(int argc, char** argv) {
+    if (argc != 3 || strcmp(argv[1], "-h") == 0) {
+        printf("Usage:\n");
+        printf("  %s <tracefile> <binary tracefile>\n",
+               argc > 0 ? basename(argv[0]) : "pfsim-convert");
+        return argc == 3 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    Trace* in = Trace_open(argv[1]);
+    if (in->format == TRACE_BINARY) {
+        fprintf(stderr, "ERROR: %s is already a binary trace\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    FILE* out = fopen(argv[2], "wb");
+    if (out == NULL) {
+        perror("Error opening output file.");
+        exit(EXIT_FAILURE);
+    }
+
+    // header is written again once the record count is known
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, TRACE_MAGIC_LEN);
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.numRecords = 0;
+    safe_fwrite(&header, sizeof(header), 1, out);
+
+    unsigned long pid;
+    unsigned long vpn;
+    while (Trace_next(in, &pid, &vpn)) {
+        if (pid == 0 || pid > UINT32_MAX) {
+            fprintf(stderr, "ERROR: Invalid pid %lu at line %lu\n", pid,
+                    (unsigned long)header.numRecords + 1);
+            exit(EXIT_FAILURE);
+        }
+        TraceRecord r = {.pid = (uint32_t)pid, .vpn = vpn};
+        safe_fwrite(&r, sizeof(r), 1, out);
+        header.numRecords++;
+    }
+
+    if (fseek(out, 0, SEEK_SET) != 0) {
+        perror("Error rewinding binary trace.");
+        exit(EXIT_FAILURE);
+    }
+    safe_fwrite(&header, sizeof(header), 1, out);
+    if (fclose(out) != 0) {
+        perror("Error closing binary trace.");
+        exit(EXIT_FAILURE);
+    }
+    Trace_close(in);
+
+    printf("%s: %lu references\n", argv[2],
+           (unsigned long)header.numRecords);
+    return EXIT_SUCCESS;
+}
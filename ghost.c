@@ -0,0 +1,146 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file ghost.c
+ * @brief Bounded ghost lists, see ghost.h.
+ * @details Entries live in one array of the table's capacity, linked into
+ * their list and their hash chain by index. The bucket array is a power of
+ * two at least twice the capacity, so chains stay short.
+ */
+
+#include "ghost.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GHOST_NIL UINT_MAX
+
+/** @return the bucket of a key, from the high bits of a mixed hash */
+static inline unsigned int Ghost_bucket(const Ghost* g, ul64 pid, ul64 vpn) {
+    uint64_t h = (pid * 0xD6E8FEB86659FD93ULL) ^ vpn;
+    // MurmurHash3's 64-bit finalizer
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h >> g->shift;
+}
+
+void Ghost_init(Ghost* g, size_t capacity) {
+    assert(capacity > 0 && capacity < GHOST_NIL);
+    unsigned int bits = 1;
+    while (((size_t)1 << bits) < 2 * capacity) bits++;
+
+    g->capacity = capacity;
+    g->shift = 64 - bits;
+    g->entries = malloc(capacity * sizeof(GhostEntry));
+    g->buckets = malloc(((size_t)1 << bits) * sizeof(unsigned int));
+    if (g->entries == NULL || g->buckets == NULL) {
+        perror("Error allocating memory for ghost lists.");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t b = 0; b < ((size_t)1 << bits); b++) g->buckets[b] = GHOST_NIL;
+    for (size_t e = 0; e < capacity; e++) {
+        g->entries[e].list = GHOST_NONE;
+        g->entries[e].next = e + 1 < capacity ? e + 1 : GHOST_NIL;
+    }
+    g->free = 0;
+    for (int l = 0; l < GHOST_MAX_LISTS; l++) {
+        g->oldest[l] = g->newest[l] = GHOST_NIL;
+        g->count[l] = 0;
+    }
+}
+
+void Ghost_free(Ghost* g) {
+    free(g->entries);
+    free(g->buckets);
+    g->entries = NULL;
+    g->buckets = NULL;
+}
+
+/** Unlinks an entry from its list and its chain, and frees it */
+static void Ghost_unlink(Ghost* g, unsigned int e) {
+    GhostEntry* entry = &g->entries[e];
+    int list = entry->list;
+    assert(list != GHOST_NONE);
+
+    if (entry->prev == GHOST_NIL) {
+        g->oldest[list] = entry->next;
+    } else {
+        g->entries[entry->prev].next = entry->next;
+    }
+    if (entry->next == GHOST_NIL) {
+        g->newest[list] = entry->prev;
+    } else {
+        g->entries[entry->next].prev = entry->prev;
+    }
+    g->count[list]--;
+
+    unsigned int* link = &g->buckets[Ghost_bucket(g, entry->pid, entry->vpn)];
+    while (*link != e) link = &g->entries[*link].chain;
+    *link = entry->chain;
+
+    entry->list = GHOST_NONE;
+    entry->next = g->free;
+    g->free = e;
+}
+
+unsigned int Ghost_push(Ghost* g, int list, ul64 pid, ul64 vpn) {
+    assert(list >= 0 && list < GHOST_MAX_LISTS);
+    if (g->free == GHOST_NIL) {
+        int victim = list;
+        while (g->count[victim] == 0) victim = (victim + 1) % GHOST_MAX_LISTS;
+        Ghost_dropOldest(g, victim);
+    }
+
+    unsigned int e = g->free;
+    GhostEntry* entry = &g->entries[e];
+    g->free = entry->next;
+
+    entry->pid = pid;
+    entry->vpn = vpn;
+    entry->list = list;
+    entry->prev = g->newest[list];
+    entry->next = GHOST_NIL;
+    if (g->newest[list] == GHOST_NIL) {
+        g->oldest[list] = e;
+    } else {
+        g->entries[g->newest[list]].next = e;
+    }
+    g->newest[list] = e;
+    g->count[list]++;
+
+    unsigned int b = Ghost_bucket(g, pid, vpn);
+    entry->chain = g->buckets[b];
+    g->buckets[b] = e;
+    return e;
+}
+
+long Ghost_find(const Ghost* g, ul64 pid, ul64 vpn) {
+    for (unsigned int e = g->buckets[Ghost_bucket(g, pid, vpn)]; e != GHOST_NIL;
+         e = g->entries[e].chain) {
+        if (g->entries[e].pid == pid && g->entries[e].vpn == vpn) return e;
+    }
+    return GHOST_NONE;
+}
+
+int Ghost_remove(Ghost* g, ul64 pid, ul64 vpn) {
+    long e = Ghost_find(g, pid, vpn);
+    if (e == GHOST_NONE) return GHOST_NONE;
+    int list = g->entries[e].list;
+    Ghost_unlink(g, e);
+    return list;
+}
+
+void Ghost_removeEntry(Ghost* g, unsigned int entry) {
+    assert(entry < g->capacity);
+    Ghost_unlink(g, entry);
+}
+
+bool Ghost_dropOldest(Ghost* g, int list) {
+    if (g->oldest[list] == GHOST_NIL) return false;
+    Ghost_unlink(g, g->oldest[list]);
+    return true;
+}
@@ -0,0 +1,96 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file ghost.h
+ * @brief Ghost lists for replacement policies that remember recently evicted
+ * pages: a bounded table of <pid, vpn> keys, each on one of a few lists kept
+ * in eviction order.
+ * @details Keys are copied, not pointers to VPages, so a ghost outlives its
+ * page (and its process). The table never holds more than the capacity it is
+ * made with, so its memory is proportional to physical memory rather than to
+ * the number of pages in the trace. All operations are O(1), expected.
+ */
+
+#ifndef _GHOST_
+#define _GHOST_
+
+#include "memory.h"
+#include <stddef.h>
+
+enum {
+    GHOST_MAX_LISTS = 4,
+    GHOST_NONE = -1, // list of a key that isn't a ghost
+};
+
+typedef struct ghost_entry_t {
+    ul64 pid;
+    ul64 vpn;
+    int list;            // GHOST_NONE while on the free list
+    unsigned int prev;   // list order, toward the oldest
+    unsigned int next;   // list order, toward the newest; or free list link
+    unsigned int chain;  // next entry in the same hash bucket
+} GhostEntry;
+
+typedef struct ghost_t {
+    GhostEntry* entries;
+    size_t capacity;
+    unsigned int* buckets; // first entry of each hash chain
+    unsigned int shift;    // hash bits dropped to index buckets
+    unsigned int free;     // first unused entry
+
+    unsigned int oldest[GHOST_MAX_LISTS];
+    unsigned int newest[GHOST_MAX_LISTS];
+    size_t count[GHOST_MAX_LISTS];
+} Ghost;
+
+/**
+ * Creates an empty table of at most capacity ghosts, over all lists.
+ */
+void Ghost_init(Ghost* g, size_t capacity);
+
+/** Frees the table */
+void Ghost_free(Ghost* g);
+
+/**
+ * Adds a page as the newest ghost of a list. The page must not be a ghost
+ * already. If the table is full, the oldest ghost of the same list (or, if
+ * it has none, of the next list that has any) is dropped to make room.
+ * @return the entry the ghost is kept in, below the capacity, which stays
+ * the same until the ghost is removed
+ */
+unsigned int Ghost_push(Ghost* g, int list, ul64 pid, ul64 vpn);
+
+/**
+ * Looks a page up without removing it.
+ * @return its entry, or GHOST_NONE if it isn't a ghost
+ */
+long Ghost_find(const Ghost* g, ul64 pid, ul64 vpn);
+
+/**
+ * @return the entry of the oldest ghost on a list, or GHOST_NONE if it is
+ * empty
+ */
+static inline long Ghost_oldest(const Ghost* g, int list) {
+    return g->count[list] > 0 ? (long)g->oldest[list] : GHOST_NONE;
+}
+
+/** Forgets the ghost kept in an entry */
+void Ghost_removeEntry(Ghost* g, unsigned int entry);
+
+/**
+ * Forgets a page, if it is a ghost.
+ * @return the list it was on, or GHOST_NONE
+ */
+int Ghost_remove(Ghost* g, ul64 pid, ul64 vpn);
+
+/**
+ * Forgets the oldest ghost of a list.
+ * @return false if the list was empty
+ */
+bool Ghost_dropOldest(Ghost* g, int list);
+
+/** @return the number of ghosts on a list */
+static inline size_t Ghost_count(const Ghost* g, int list) {
+    return g->count[list];
+}
+
+#endif
@@ -13,11 +13,17 @@
 
 // Node constructor
 IntervalNode* it_initnode(size_t low, size_t high) {
-    IntervalNode* in;
-    if ((in = (IntervalNode*)malloc(sizeof(IntervalNode))) == NULL) {
+    void* in;
+    if ((in = malloc(sizeof(IntervalNode))) == NULL) {
         perror("Error allocating memory for new node.");
         exit(EXIT_FAILURE);
     }
+    return it_placenode(in, low, high);
+}
+
+// Node constructor, for storage the caller allocated
+IntervalNode* it_placenode(void* storage, size_t low, size_t high) {
+    IntervalNode* in = storage;
     in->low = low;
     in->high = high;
     in->max = high;
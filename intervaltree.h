@@ -16,7 +16,7 @@ typedef struct interval_node_t {
     size_t low; // low of current interval
     size_t high; // high of current interval
     size_t max; // max value present throughout entire subtree given by node
-    long fpos_start;
+    long fpos_start; // trace position of line low (Trace_tell)
 
     struct interval_node_t* left; // pointer to left interval node
     struct interval_node_t* right; // pointer to right interval node
@@ -30,6 +30,12 @@ bool it_contains(size_t low, size_t high, size_t x);
  */
 IntervalNode* it_initnode(size_t low, size_t high);
 
+/**
+ * Initializes an interval node in caller-provided storage
+ * @return storage, as an IntervalNode
+ */
+IntervalNode* it_placenode(void* storage, size_t low, size_t high);
+
 /**
  * Inserts an interval node into the tree.
  * 
@@ -9,18 +9,60 @@
 
 #define _GNU_SOURCE
 
+#include "alloc.h"
 #include "intervaltree.h"
 #include "memory.h"
+#include "mrc.h"
 #include "process.h"
 #include "replace.h"
+#include "sample.h"
 #include "simulator.h"
 #include "stat.h"
 #include "trace_parser.h"
+#include "trace_reader.h"
 
 #include <errno.h>
 #include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
 #include <string.h>
 
+// long options without a short form
+enum { OPT_MRC = 256, OPT_MRC_CHECK, OPT_SEED };
+
+static const struct option longOptions[] = {
+  {"mrc", no_argument, NULL, OPT_MRC},
+  {"mrc-check", no_argument, NULL, OPT_MRC_CHECK},
+  {"seed", required_argument, NULL, OPT_SEED},
+  {NULL, 0, NULL, 0},
+};
+
+// A simulator run on its own thread, in lockstep mode
+typedef struct sim_job_t {
+    Simulator* sim;
+    SimulatorEngine engine;
+    unsigned long time; // result
+} SimJob;
+
+/** Thread body for lockstep mode: runs one simulator in columnar mode */
+static void* runJob(void* arg) {
+    SimJob* job = arg;
+    job->time = Simulator_runSimulation(job->sim, NULL, job->engine);
+    return NULL;
+}
+
+/**
+ * Parses a whole option argument as a decimal integer
+ * @return true, with the integer in *value, if arg is one and nothing else,
+ * and it is in [min, max]
+ */
+static bool parseInteger(const char* arg, long min, long max, long* value) {
+    char* end;
+    errno = 0;
+    *value = strtol(arg, &end, 10);
+    return errno == 0 && end != arg && *end == '\0' && *value >= min
+           && *value <= max;
+}
 
 /**
  * Parses args, validates memory size and page size
@@ -29,52 +71,202 @@
  * @param[out] memsize total size of memory in bytes
  * @param[out] pagesize size of one page in bytes
  * @param[out] filename provided trace file name
+ * @param[out] columns true if the trace should be decoded into per-process
+ * columns during the first pass
+ * @param[out] threads number of threads for the first pass
+ * @param[out] engine simulation engine to run
+ * @param[out] pageTables true if -t picked a page table, which also asks for
+ * a report of page table sizes
+ * @param[out] allocStats true to print allocator counters at the end
+ * @param[out] processStats true to print each process's fault rate at the end
+ * @param[out] policies replacement policies to run, from -a, or else named by
+ * the executable (pfsim-<policy>), or else LRU
+ * @param[out] numPolicies number of policies
+ * @param[out] mrc 0 to simulate, 1 to compute the LRU miss ratio curve
+ * instead, 2 to also check it against the LRU policy
+ * @param[out] sampleRate fraction of pages to simulate, or 0 for all
+ * @param[out] samplePages most pages to simulate, or 0 for no limit
  * @returns values via the parameter fields labeled "out", or exits with an error if invalid input provided.
  * */
 inline static void parseArgs(int argc, char** argv, int* memsize, int* pagesize,
-                             char** filename) {
+                             char** filename, bool* columns, int* threads,
+                             SimulatorEngine* engine, bool* pageTables,
+                             bool* allocStats, bool* processStats,
+                             ReplaceSpec* policies,
+                             int* numPolicies, int* mrc, double* sampleRate,
+                             long* samplePages) {
+    // default policy comes from the name the simulator was run as
+    *numPolicies = 1;
+    Replace_parsePolicy("lru", &policies[0]);
+    if (argv != NULL && argv[0] != NULL
+        && strncmp(basename(argv[0]), "pfsim-", 6) == 0) {
+        Replace_parsePolicy(basename(argv[0]) + 6, &policies[0]);
+    }
+
     // use getopt to handle input
+    unsigned long long seed = 1;
+    long value;
     int opt = 0;
-    while ((opt = getopt(argc, argv, "-p:m:h")) != -1) {
-        switch ((char)opt) {
-            case 'm':
+    while ((opt = getopt_long(argc, argv, "-p:m:j:e:t:a:s:S:cMPh", longOptions,
+                              NULL))
+           != -1) {
+        switch (opt) {
+            case OPT_MRC:
+                if (*mrc == 0) *mrc = 1;
+                break;
+            case OPT_MRC_CHECK:
+                *mrc = 2;
+                break;
+            case OPT_SEED: {
+                assert(optarg != NULL);
+                char* end;
+                errno = 0;
+                seed = strtoull(optarg, &end, 10);
+                if (errno != 0 || end == optarg || *end != '\0'
+                    || optarg[0] == '-') {
+                    fprintf(stderr, "Error parsing --seed, must be a "
+                                    "non-negative integer.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 's': {
                 assert(optarg != NULL);
+                char* end;
                 errno = 0;
-                *memsize = (int)strtol(optarg, NULL, 10);
-                if (errno != 0) {
+                *sampleRate = strtod(optarg, &end);
+                if (errno != 0 || end == optarg || *end != '\0'
+                    || !(*sampleRate > 0 && *sampleRate <= 1)) {
+                    fprintf(stderr, "Error parsing -s, must be a sampling "
+                                    "rate greater than 0 and at most 1.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 'S':
+                assert(optarg != NULL);
+                if (!parseInteger(optarg, 1, LONG_MAX, samplePages)) {
+                    fprintf(stderr,
+                            "Error parsing -S, must be a positive integer.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'a':
+                assert(optarg != NULL);
+                *numPolicies = Replace_parsePolicyList(optarg, policies);
+                if (*numPolicies == 0) {
+                    fprintf(stderr, "Error parsing -a, must be a list of "
+                                    "distinct policies, each one of\n\t"
+                                    REPLACE_POLICY_NAMES ".\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'e':
+                assert(optarg != NULL);
+                if (strcmp(optarg, "event") == 0) {
+                    *engine = ENGINE_EVENT;
+                } else if (strcmp(optarg, "tick") == 0) {
+                    *engine = ENGINE_TICK;
+                } else {
+                    fprintf(stderr,
+                            "Error parsing -e, must be 'event' or 'tick'.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 't':
+                assert(optarg != NULL);
+                *pageTables = true;
+                if (strcmp(optarg, "hash") == 0) {
+                    PageTable_configure(PAGETABLE_HASH, 0);
+                } else if (strncmp(optarg, "radix", 5) == 0
+                           && (optarg[5] == '\0' || optarg[5] == ':')) {
+                    long levels = PAGETABLE_RADIX_DEFAULT_LEVELS;
+                    if (optarg[5] == ':'
+                        && !parseInteger(optarg + 6, INT_MIN, INT_MAX,
+                                         &levels)) {
+                        levels = 0; // rejected by PageTable_configure
+                    }
+                    PageTable_configure(PAGETABLE_RADIX, (int)levels);
+                } else {
+                    fprintf(stderr, "Error parsing -t, must be 'hash' or "
+                                    "'radix[:levels]'.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                *columns = true;
+                break;
+            case 'M':
+                *allocStats = true;
+                break;
+            case 'P':
+                *processStats = true;
+                break;
+            case 'j':
+                assert(optarg != NULL);
+                if (!parseInteger(optarg, 1, INT_MAX, &value)) {
+                    fprintf(stderr,
+                            "Error parsing -j, must be a positive integer.\n");
+                    exit(EXIT_FAILURE);
+                }
+                *threads = (int)value;
+                break;
+            case 'm':
+                assert(optarg != NULL);
+                if (!parseInteger(optarg, INT_MIN, INT_MAX, &value)) {
                     fprintf(stderr,
                             "Error parsing -m, must be a valid integer.\n");
                     exit(EXIT_FAILURE);
                 }
+                *memsize = (int)value;
                 break;
             case 'p':
                 assert(optarg != NULL);
-                errno = 0;
-                *pagesize = (int)strtol(optarg, NULL, 10);
-                if (errno != 0) {
+                if (!parseInteger(optarg, INT_MIN, INT_MAX, &value)) {
                     fprintf(stderr,
                             "Error parsing -p, must be a valid integer.\n");
                     exit(EXIT_FAILURE);
                 }
+                *pagesize = (int)value;
                 break;
             case 'h':
                 // help message printed by '-h'
                 printf("Usage:\n");
                 printf(
-                  "  ./pfsim-lru [-m real memory size] [-p page size] "
-                  "<tracefile>\n");
-                printf(
-                  "  ./pfsim-fifo [-m real memory size] [-p page size] "
+                  "  ./pfsim [-a policies] [-m real memory size] [-p page size] "
+                  "[-c]\n\t[-j threads] [-e engine] [-t page table] "
+                  "[-s rate | -S pages] [-M] [-P]\n\t[--seed N] "
                   "<tracefile>\n");
                 printf(
-                  "  ./pfsim-clock [-m real memory size] [-p page size] "
-                  "<tracefile>\n");
+                  "  ./pfsim --mrc [--mrc-check] [-m real memory size] "
+                  "[-p page size]\n\t[-t page table] <tracefile>\n");
                 printf(
-                  "  ./pfsim-random [-m real memory size] [-p page size] "
-                  "<tracefile>\n");
+                  "  ./pfsim-lru, ./pfsim-fifo, ./pfsim-clock, ./pfsim-random, "
+                  "./pfsim-arc,\n\t./pfsim-clockpro, ./pfsim-lirs, "
+                  "./pfsim-opt, ./pfsim-lfu, ./pfsim-wsclock,\n\t"
+                  "./pfsim-pff, ./pfsim-sampled, ./pfsim-mglru,\n\t"
+                  "./pfsim-s3fifo, ./pfsim-tinylfu: same, with that policy as "
+                  "the\n\tdefault.\n");
                 printf("\nOptions:\n");
                 printf("  -h\t");
                 printf("Prints this message.\n");
+                printf("  -a\t");
+                printf(
+                  "Replacement policies to simulate, comma separated, each "
+                  "one of\n\t" REPLACE_POLICY_NAMES ".\n\tWith more "
+                  "than one, each runs on its own thread and copy of the\n\t"
+                  "processes, in columnar mode, and the results are "
+                  "printed side by side.\n\tDefaults to the policy in the "
+                  "program name, or lru. opt reads ahead\n\tin the "
+                  "references, so it implies -c, and indexes them at another "
+                  "8\n\tbytes per reference. lfu:N halves LFU's reference "
+                  "counts every N\n\treferences. wsclock:N sets WSClock's "
+                  "working set window, and pff:N\n\tPFF's fault interval "
+                  "threshold, to N references of a process. sampled:K\n\t"
+                  "draws K frames per eviction. tinylfu:lru, :clock or :fifo "
+                  "put TinyLFU's\n\tadmission in front of that policy "
+                  "instead of its segmented LRU.\n\tA policy may be listed "
+                  "more than once with different parameters.\n");
                 printf("  -m\t");
                 printf(
                   "Amount of physical memory avaliable, in megabytes. "
@@ -83,6 +275,61 @@ inline static void parseArgs(int argc, char** argv, int* memsize, int* pagesize,
                 printf(
                   "Page size as a number of bytes, must be a power of two. "
                   "Defaults to 4096 bytes.\n");
+                printf("  -c\t");
+                printf(
+                  "Columnar mode: decode each process's references into "
+                  "memory during the\n\tfirst pass, so the simulation "
+                  "never seeks the trace. Costs 8 bytes per\n\treference.\n");
+                printf("  -j\t");
+                printf(
+                  "Number of threads to scan the trace with in the first "
+                  "pass. Defaults to 1.\n");
+                printf("  -e\t");
+                printf(
+                  "Simulation engine: 'event' jumps from event to event, "
+                  "'tick' steps\n\tone clock tick at a time. Both give "
+                  "identical results. Defaults to\n\tevent.\n");
+                printf("  -t\t");
+                printf(
+                  "Page table structure: 'hash' (default) or 'radix', "
+                  "optionally with a\n\tlevel count as 'radix:3' "
+                  "(default 4, 9 VPN bits per level). Also\n\tprints each "
+                  "process's page table size at the end.\n");
+                printf("  -s\t");
+                printf(
+                  "Sampled simulation: only simulate this fraction of the "
+                  "pages, picked by\n\thashing, in memory scaled down by "
+                  "the same rate, and scale the\n\tresults back up. Implies "
+                  "-c.\n");
+                printf("  -S\t");
+                printf(
+                  "Sampled simulation of at most this many pages, at "
+                  "whatever rate that\n\ttakes. Costs an extra pass over "
+                  "the trace.\n");
+                printf("  --mrc\t");
+                printf(
+                  "Instead of simulating, prints the LRU page fault count "
+                  "for every memory\n\tsize, from one pass over the trace "
+                  "in file order.\n");
+                printf("  --mrc-check\n\t");
+                printf(
+                  "Same as --mrc, then replays the trace through the LRU "
+                  "policy at several\n\tmemory sizes to check the "
+                  "curve.\n");
+                printf("  -M\t");
+                printf(
+                  "Prints allocation counters for the slab pools and "
+                  "per-process arenas\n\tat the end.\n");
+                printf("  -P\t");
+                printf(
+                  "Prints each process's faults per 1000 references and "
+                  "finishing time at\n\tthe end, for each policy. Not "
+                  "scaled when sampling.\n");
+                printf("  --seed N\n\t");
+                printf(
+                  "Seeds the generator of each policy that draws frames at "
+                  "random (random\n\tand sampled), to repeat a run with "
+                  "other draws. Defaults to 1.\n");
 
                 exit(EXIT_FAILURE);
                 break;
@@ -104,6 +351,9 @@ inline static void parseArgs(int argc, char** argv, int* memsize, int* pagesize,
         }
     }
 
+    // --seed applies to every policy, wherever it was given
+    for (int i = 0; i < *numPolicies; i++) policies[i].seed = seed;
+
     // validate page size
     if (*pagesize && *pagesize % 2 != 0) {
         fprintf(stderr, "ERROR: page size must be a power of two\n");
@@ -122,6 +372,9 @@ inline static void parseArgs(int argc, char** argv, int* memsize, int* pagesize,
     if (*memsize < 0) {
         fprintf(stderr, "ERROR: memory size must be positive\n");
         exit(EXIT_FAILURE);
+    } else if (*memsize >= 2048) {
+        fprintf(stderr, "ERROR: memory size must be under 2048 MB\n");
+        exit(EXIT_FAILURE);
     } else if (*memsize == 0) {
         fprintf(stderr,
                 "\x1B[2mWARN: memory size (-m) not specified, defaulting to 1 MB\x1B[0m\n");
@@ -156,41 +409,163 @@ int main(int argc, char** argv) {
     int memsize = 0;
     int pagesize = 0;
     char* filename = NULL;
-    parseArgs(argc, argv, &memsize, &pagesize, &filename);
+    bool columns = false;
+    int threads = 1;
+    SimulatorEngine engine = ENGINE_EVENT;
+    bool pageTables = false;
+    bool allocStats = false;
+    bool processStats = false;
+    ReplaceSpec policies[REPLACE_MAX_POLICIES];
+    int numPolicies = 0;
+    int mrc = 0;
+    double sampleRate = 0;
+    long samplePages = 0;
+    parseArgs(argc, argv, &memsize, &pagesize, &filename, &columns, &threads,
+              &engine, &pageTables, &allocStats, &processStats, policies,
+              &numPolicies, &mrc, &sampleRate, &samplePages);
     assert(memsize > 0);
     assert(pagesize > 0);
     assert(filename != NULL);
+    assert(numPolicies > 0);
     
     int numberOfPhysicalPages = memsize / pagesize;
     assert(numberOfPhysicalPages > 0);
 
-    // 2. Open tracefile
-    FILE* tracefile = NULL;
-    tracefile = fopen(filename, "r");
-    if (tracefile == NULL) {
-        fprintf(stderr, "ERROR: error opening specified trace file\n");
-        exit(EXIT_FAILURE);
+    // simulators running side by side can't share the trace's read position
+    bool lockstep = numPolicies > 1;
+    // sampled lines are skipped in the first pass, and only there
+    bool sampling = !mrc && (sampleRate > 0 || samplePages > 0);
+    // OPT reads each reference's next use from an index over the columns
+    bool lookahead = false;
+    for (int i = 0; i < numPolicies; i++) {
+        lookahead |= !mrc && policies[i].policy == REPLACE_OPT;
     }
+    if (lockstep || sampling || lookahead) columns = true;
+
+    // 2. Open tracefile
+    Trace* trace = Trace_open(filename);
     
     printf("\x1B[1m\x1B[7m%s\x1B[0m\n"," PARAMETERS ");
-    printf("  \x1B[1m%s\x1B[0m\n", filename);
+    printf("  \x1B[1m%s\x1B[0m (%s)\n", filename,
+           trace->format == TRACE_BINARY ? "binary" : "text");
     printf("  page size: %i B\n", pagesize);
     printf("  memory size: %i MB\n", memsize/0x100000);
     printf("  = %i pages\n", numberOfPhysicalPages);
+    if (columns) printf("  columnar references\n");
+    if (threads > 1) printf("  first pass threads: %i\n", threads);
+    if (engine == ENGINE_TICK) printf("  tick engine\n");
+    if (mrc) {
+        Mrc_run(trace, pagesize, numberOfPhysicalPages, mrc == 2);
+        Trace_close(trace);
+        if (allocStats) Alloc_printStats();
+        return EXIT_SUCCESS;
+    }
+    if (lockstep) {
+        printf("  policies:");
+        for (int i = 0; i < numPolicies; i++) {
+            printf(" %s", policies[i].name);
+        }
+        printf("\n");
+    }
+    Sample sample;
+    if (sampling) {
+        if (samplePages > 0) {
+            Sample_initSize(&sample, trace, samplePages,
+                            numberOfPhysicalPages);
+        } else {
+            Sample_initRate(&sample, sampleRate, numberOfPhysicalPages);
+        }
+        printf("  sampling rate: %f (%i pages of memory)\n", sample.rate,
+               sample.frames);
+    }
 
-    // 3. Initialize helper modules
-    Memory_init(numberOfPhysicalPages);
-    Replace_initReplacementModule(numberOfPhysicalPages);
-    Stat_init();
-    ProcessQueues_init();
+    // 3. Initialize a simulator per policy
+    Simulator* sims = malloc(numPolicies * sizeof(Simulator));
+    if (sims == NULL) {
+        perror("Error allocating memory for simulators.");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < numPolicies; i++) {
+        Simulator_init(&sims[i], &policies[i],
+                       sampling ? sample.frames : numberOfPhysicalPages);
+        if (sampling) sims[i].sample = &sample;
+    }
 
-    // 4. Read "first pass", ennumerating pids and building interval tree
-    first_pass(tracefile);
+    // 4. Read "first pass", ennumerating pids and building interval tree. In
+    // lockstep mode the processes are read once into a template and every
+    // simulator gets its own copy.
+    ProcessQueues template;
+    ProcessQueues_init(&template);
+    first_pass(lockstep ? &template : &sims[0].queues, trace, columns,
+               sampling ? &sample : NULL, threads);
+    if (lookahead) {
+        size_t bytes =
+          first_pass_nextUse(lockstep ? &template : &sims[0].queues);
+        printf("  next-use index: %.1f MB\n", bytes / (double)0x100000);
+    }
+    if (columns) { // everything needed is in the columns now
+        Trace_close(trace);
+        trace = NULL;
+    }
+    if (lockstep) {
+        for (int i = 0; i < numPolicies; i++) {
+            ProcessQueues_clone(&sims[i].queues, &template);
+        }
+    }
 
-    // 5. Run the simulation
-    unsigned long exit_time = Simulator_runSimulation(tracefile);
+    // 5. Run the simulation(s)
+    SimJob* jobs = malloc(numPolicies * sizeof(SimJob));
+    pthread_t* workers = malloc(numPolicies * sizeof(pthread_t));
+    if (jobs == NULL || workers == NULL) {
+        perror("Error allocating memory for simulation threads.");
+        exit(EXIT_FAILURE);
+    }
+    if (!lockstep) {
+        jobs[0].time = Simulator_runSimulation(&sims[0], trace, engine);
+        Trace_close(trace);
+    } else {
+        for (int i = 0; i < numPolicies; i++) {
+            jobs[i] = (SimJob){&sims[i], engine, 0};
+            errno = pthread_create(&workers[i], NULL, runJob, &jobs[i]);
+            if (errno != 0) {
+                perror("Couldn't start simulation thread.");
+                exit(EXIT_FAILURE);
+            }
+        }
+        for (int i = 0; i < numPolicies; i++) pthread_join(workers[i], NULL);
+    }
+
+    // 6. Output results, scaled up to the whole trace if sampled
+    const char* names[REPLACE_MAX_POLICIES];
+    StatSummary results[REPLACE_MAX_POLICIES];
+    const unsigned long* groupFaults[REPLACE_MAX_POLICIES];
+    for (int i = 0; i < numPolicies; i++) {
+        names[i] = policies[i].name;
+        results[i] = Stat_summarize(&sims[i].stats, jobs[i].time);
+        if (sampling) results[i] = Sample_scale(&sample, results[i]);
+        groupFaults[i] = sims[i].sampleFaults;
+    }
+    if (!lockstep) {
+        Stat_printSummary(&results[0]);
+    } else {
+        Stat_printTable(names, results, numPolicies);
+    }
+    for (int i = 0; i < numPolicies; i++) Replace_printStats(&sims[i].replace);
+    if (sampling) Sample_printStats(&sample, names, groupFaults, numPolicies);
+    // page tables don't depend on the policy, so any simulator's will do
+    if (pageTables) Stat_printPageTables(&sims[0].stats);
+    if (processStats) {
+        Stats* runs[REPLACE_MAX_POLICIES];
+        for (int i = 0; i < numPolicies; i++) runs[i] = &sims[i].stats;
+        Stat_printProcesses(names, runs, numPolicies);
+    }
+    if (allocStats) Alloc_printStats();
 
-    // 6. Output results
-    Stat_printStats(exit_time);
+    // 7. Clean up; clones go before the template they share intervals with
+    for (int i = 0; i < numPolicies; i++) Simulator_free(&sims[i]);
+    ProcessQueues_free(&template);
+    free(workers);
+    free(jobs);
+    free(sims);
     return EXIT_SUCCESS;
 }
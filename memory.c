@@ -1,39 +1,27 @@
 #include "memory.h"
-#include "replace.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/queue.h>
 
-// a representation of physical memory
-static PPage** memory;
-// holds memory size in pages
-static size_t mem_size;
-// holds the number of allocated pages
-static size_t allocated;
-
-// BitMap/Bitvector containing a 0 or 1 at a position given by the PPN,
-// depending on whether the page is allocated or not, respectively.
-static freelist_t freelist;
-
 // returns the index in the bitmap array which corresponds to the
-// integer chunk given by n
-static inline ul64 bv_ind(ul64 n) { return n / 32; }
+// word holding bit n
+static inline ul64 bv_ind(ul64 n) { return n / 64; }
 
-// returns the offset in a chunk of a bitmap array given by n
-static inline unsigned int bv_ofs(ul64 n) { return n % 32; }
+// returns the mask of bit n within its word, LSB indexed
+static inline uint64_t bv_bit(ul64 n) { return (uint64_t)1 << (n % 64); }
 
-// finds the index of the first 0 (unallocated) in a freelist chunk
-// MSB indexed starting at 0, -1 if there are no 0s
-static inline int bv_ffz(unsigned int n) {
-    return (~n == 0) ? -1 : __builtin_clz(~n);
+// finds the index of the lowest 1 (free) in a freelist word, -1 if there are
+// no 1s
+static inline int bv_ffs(uint64_t n) {
+    return n == 0 ? -1 : __builtin_ctzll(n);
 }
 
 /**
  * Initialize a new free page at the ppn specified.
  * @ppn ppn of page to create
  */
-static PPage* Page_init(ul64 ppn) {
+static PPage* Page_init(Memory* m, ul64 ppn) {
     PPage* p = malloc(sizeof(PPage));
     if (p == NULL) {
         perror("memory allocation failed");
@@ -43,30 +31,90 @@ static PPage* Page_init(ul64 ppn) {
     p->ppn = ppn;
     p->virtualPage = NULL;
 
-    memory[ppn] = p;
+    m->memory[ppn] = p;
 
     return p;
 }
 
 /**
- * Initialize Memory module.
+ * Initialize a Memory.
  * @param numberOfPhysicalPages amount of physical memory/page size
  */
-void Memory_init(size_t numberOfPhysicalPages) {
+void Memory_init(Memory* m, size_t numberOfPhysicalPages) {
     // allocate contiguous chunk of memory to be "Memory", O(1) ppn resolution
     // via indexing
-    mem_size = numberOfPhysicalPages;
-    allocated = 0;
-    memory = malloc(mem_size * sizeof(PPage));
-    if (memory == NULL) {
+    m->mem_size = numberOfPhysicalPages;
+    m->allocated = 0;
+    m->memory = malloc(m->mem_size * sizeof(PPage*));
+    if (m->memory == NULL) {
         perror("memory allocation failed");
         exit(EXIT_FAILURE);
     }
 
-    freelist = (freelist_t)calloc(sizeof(unsigned int), (mem_size / 32));
+    // every page starts out free; bits past the last page stay 0 so they are
+    // never handed out
+    size_t bits = m->mem_size;
+    m->levels = 0;
+    do {
+        assert(m->levels < MEMORY_MAX_LEVELS);
+        size_t words = (bits + 63) / 64;
+        freelist_t level = calloc(words > 0 ? words : 1, sizeof(uint64_t));
+        if (level == NULL) {
+            perror("memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t b = 0; b < bits; b++) level[bv_ind(b)] |= bv_bit(b);
+        m->freelist[m->levels++] = level;
+        bits = words;
+    } while (bits > 1);
 
     // initialize all pages
-    for (size_t p = 0; p < mem_size; p++) { Page_init(p); }
+    for (size_t p = 0; p < m->mem_size; p++) { Page_init(m, p); }
+}
+
+/**
+ * Marks a page free (or taken), updating each level above it whose word went
+ * from empty to not (or back).
+ */
+static inline void Memory_markFree(Memory* m, ul64 ppn, bool isFree) {
+    for (int l = 0; l < m->levels; l++) {
+        uint64_t* word = &m->freelist[l][bv_ind(ppn)];
+        bool wasEmpty = *word == 0;
+        if (isFree) {
+            *word |= bv_bit(ppn);
+        } else {
+            *word &= ~bv_bit(ppn);
+        }
+        if (wasEmpty == (*word == 0)) break; // summary bit above is unchanged
+        ppn = bv_ind(ppn);
+    }
+}
+
+/**
+ * @return the number of free pages according to the bitmap, in O(n/64)
+ */
+__attribute__((unused)) static size_t Memory_countFreePages(Memory* m) {
+    size_t count = 0;
+    for (size_t w = 0; w < (m->mem_size + 63) / 64; w++) {
+        count += __builtin_popcountll(m->freelist[0][w]);
+    }
+    return count;
+}
+
+/**
+ * Frees a Memory's pages. Virtual pages still loaded are left as they are.
+ */
+void Memory_free(Memory* m) {
+    // the bitmap must agree with the counter
+    assert(m->mem_size - Memory_countFreePages(m) == m->allocated);
+    for (size_t p = 0; p < m->mem_size; p++) free(m->memory[p]);
+    free(m->memory);
+    for (int l = 0; l < m->levels; l++) {
+        free(m->freelist[l]);
+        m->freelist[l] = NULL;
+    }
+    m->memory = NULL;
+    m->levels = 0;
 }
 
 /**
@@ -74,40 +122,43 @@ void Memory_init(size_t numberOfPhysicalPages) {
  * @param ppn index into memory
  * @return PPage at that index
  */
-PPage* Memory_getPPage(ul64 ppn) {
-    if (ppn > mem_size - 1) {
+PPage* Memory_getPPage(Memory* m, ul64 ppn) {
+    if (ppn > m->mem_size - 1) {
         perror("ERROR: Tried to access a physical page that is out of bounds");
         exit(EXIT_FAILURE);
     }
-    return memory[ppn];
+    return m->memory[ppn];
 }
 
 /**
  * Accesses the virtual page with a given ppn
  */
-VPage* Memory_getVPage(ul64 ppn) { return memory[ppn]->virtualPage; }
+VPage* Memory_getVPage(Memory* m, ul64 ppn) {
+    return m->memory[ppn]->virtualPage;
+}
 
 /**
  * Frees the page at a given ppn by sending the virtual page to backing store
  */
-void Memory_evictPage(ul64 ppn) {
-    assert(memory != NULL);
-    if (ppn > mem_size - 1) {
+void Memory_evictPage(Memory* m, ul64 ppn) {
+    assert(m->memory != NULL);
+    if (ppn > m->mem_size - 1) {
         perror("ERROR: Tried to access a physical page that is out of bounds");
         exit(EXIT_FAILURE);
     }
-    assert(memory[ppn] != NULL && "Physical page should always exist.");
-    memory[ppn]->virtualPage->inMemory = false;
-    memory[ppn]->virtualPage = NULL;
-
-    // remove page from free list (mark as clear)
-    if ((freelist[bv_ind(ppn)] << bv_ofs(ppn) & 2147483648) == 2147483648) {
-        freelist[bv_ind(ppn)] ^= 2147483648 >> bv_ofs(ppn); // flip to low
-        allocated--; // tick allocated counter
+    assert(m->memory[ppn] != NULL && "Physical page should always exist.");
+    VPage* v = m->memory[ppn]->virtualPage;
+    v->inMemory = false;
+    if (v->owner != NULL) v->owner->pages--;
+    m->memory[ppn]->virtualPage = NULL;
+
+    // add page back to the free list (mark as free)
+    if ((m->freelist[0][bv_ind(ppn)] & bv_bit(ppn)) == 0) {
+        Memory_markFree(m, ppn, true);
+        m->allocated--; // tick allocated counter
     } else {
         perror("WARN: failsafe triggered");
     }
-    // freelist[bv_ind(ppn)] |= 2147483648 >> bv_ofs(ppn); // set high
 }
 
 /**
@@ -116,93 +167,80 @@ void Memory_evictPage(ul64 ppn) {
  * @param virtualPage page to load as replacement
  * @param PPN location to load in memory
  */
-void Memory_loadPage(VPage* virtualPage, ul64 ppn) {
-    if (ppn > mem_size - 1) {
+void Memory_loadPage(Memory* m, VPage* virtualPage, ul64 ppn) {
+    if (ppn > m->mem_size - 1) {
         perror("ERROR: Tried to access a physical page that is out of bounds");
         exit(EXIT_FAILURE);
     }
     assert(virtualPage != NULL);
-    assert(memory[ppn]->virtualPage == NULL);
-    memory[ppn]->virtualPage = virtualPage;
+    assert(m->memory[ppn]->virtualPage == NULL);
+    m->memory[ppn]->virtualPage = virtualPage;
 
     virtualPage->inMemory = true;
     virtualPage->currentPPN = ppn;
+    if (virtualPage->owner != NULL) virtualPage->owner->pages++;
 
-    // add page to free list (mark as taken)
-    // OR with an integer containing 1 at the offset given by PPN
-    // has effect of setting to 1 at the offset position
-    freelist[bv_ind(ppn)] |= 2147483648 >> bv_ofs(ppn);
-    allocated++; // tick allocated counter
+    // remove page from the free list (mark as taken)
+    assert(m->freelist[0][bv_ind(ppn)] & bv_bit(ppn));
+    Memory_markFree(m, ppn, false);
+    m->allocated++; // tick allocated counter
 }
 
 /**
+ * Finds the lowest free ppn by walking down from the single top word, taking
+ * the lowest 1 of each level, so it costs one ctz per level.
  * @return the ppn of the next free page, or an out of bounds index if none
  */
-ul64 Memory_getFreePage() {
-    for (ul64 fl_ind = 0; fl_ind < mem_size / 32; fl_ind++) {
-        // printf("\x1B[34m %d \n\x1B[0m", freelist[fl_ind]);
-        int fz_ind = bv_ffz(freelist[fl_ind]);
-        if (fz_ind >= 0) {
-            // printf("\x1B[35m %lu %d \n\x1B[0m", fl_ind * 32 + fz_ind,
-            // fz_ind);
-            return fl_ind * 32 + fz_ind;
-        }
+ul64 Memory_getFreePage(Memory* m) {
+    ul64 ind = 0;
+    for (int l = m->levels - 1; l >= 0; l--) {
+        int fs_ind = bv_ffs(m->freelist[l][ind]);
+        if (fs_ind < 0) break; // only possible at the top, memory is full
+        ind = ind * 64 + fs_ind;
+        if (l == 0) return ind;
     }
     perror(
       "WARN: Tried to get free page when none are avaliable. Use "
       "Memory_hasFreePage to check first.");
     exit(EXIT_FAILURE);
-    return mem_size + 1; // out-of-bounds value as sentinel
+    return m->mem_size + 1; // out-of-bounds value as sentinel
 }
 
 /**
  * @return true if there is a free page in memory
  */
-bool Memory_hasFreePage() {
+bool Memory_hasFreePage(Memory* m) {
     //printf("\x1B[35m allocated pages: %lu \n total pages: %lu \n\x1B[0m",
     //       allocated, mem_size);
-    return mem_size > allocated;
+    return m->mem_size > m->allocated;
 }
 
 /**
  * @return the number of allocated pages, given by the allocated variable.
  */
-int Memory_howManyAllocPages() { return allocated; }
+int Memory_howManyAllocPages(Memory* m) { return m->allocated; }
 
 /**
  * @return the size of memory in pages
  */
-int Memory_getTotalSize() { return mem_size; }
+int Memory_getTotalSize(Memory* m) { return m->mem_size; }
 
 /**
  * Constructs a new Virtual Page given it's virtual identifier.
  * Used by Page Table to get virtual pages.
+ * @param arena arena of the owning process
  * @param pid process id
  * @param vpn virtual page number
+ * @param owner resident set of the owning process, or NULL
  * @return pointer to new VPage struct.
  */
-VPage* VPage_init(ul64 pid, ul64 vpn) {
-    VPage* v = malloc(sizeof(VPage));
-    if (v == NULL) {
-        perror("memory allocation failed");
-        exit(EXIT_FAILURE);
-    }
+VPage* VPage_init(Arena* arena, ul64 pid, ul64 vpn, ResidentSet* owner) {
+    VPage* v = Arena_alloc(arena, sizeof(VPage)); // zeroed
 
     v->pid = pid;
     v->vpn = vpn;
+    v->owner = owner;
     v->inMemory = false;
 
-    if (pid != 0) {
-        v->overhead = Replace_initOverhead(v);
-    } else {
-        v->overhead = NULL;
-    }
-
     return v;
 }
-
-void VPage_free(VPage* vp) {
-    if (vp->inMemory) Memory_evictPage(vp->currentPPN);
-    if (vp->overhead != NULL) Replace_freeOverhead(vp->overhead);
-    free(vp);
-}
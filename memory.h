@@ -1,7 +1,9 @@
 // Simulates memory.
 
+#include "alloc.h"
 #include "intervaltree.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/queue.h>
 
 #ifndef _MEMORY_
@@ -18,17 +20,79 @@
 ^*page
 */
 
-typedef unsigned int* freelist_t;
+typedef uint64_t* freelist_t;
+
+// levels of the free page bitmap; 64^6 frames is far more than ever needed
+#define MEMORY_MAX_LEVELS 6
 // use a better name? unsigned long was appearing in too 
 // many places, it was getting quite long to type out
 typedef unsigned long ul64; 
 
+// One process's share of memory. The page count is kept up to date by
+// Memory_loadPage and Memory_evictPage, for policies that manage each
+// process's frames (WSClock, PFF) rather than memory as a whole.
+typedef struct resident_set_t {
+    ul64 pages;       // resident now
+    ul64 virtualTime; // references the process has run so far
+
+    // per-process state of the replacement policy, like ReplaceMeta
+    union {
+        struct {
+            ul64 allowance;  // frames the process may keep when others fault
+            ul64 used;       // resident pages referenced since lastShrink
+            ul64 lastFault;  // virtual time of the last fault
+            ul64 lastShrink; // virtual time of the last infrequent fault
+            bool over;       // more pages than allowance, counted by PFF
+        } pff;
+    } meta;
+} ResidentSet;
+
+// Per-page state of the replacement policy, kept inline so the policy's
+// hooks never chase a pointer. Each policy uses only its own member, and only
+// while the page is in memory; see replace.h.
+typedef union replace_meta_t {
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in the LRU queue
+    } lru;
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in the FIFO queue
+    } fifo;
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in T1 or T2
+        bool frequent;                // in T2, referenced more than once
+    } arc;
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in its bucket
+        struct lfu_bucket_t* bucket;  // pages referenced as often as this one
+    } lfu;
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in its generation
+        unsigned char gen;            // generation's sequence number, mod 4
+        bool accessed;                // referenced since last aged or loaded
+    } mglru;
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in the small or main queue
+        unsigned char freq;           // hits, saturating at 3
+        bool main;                    // in the main queue, not the small one
+    } s3fifo;
+    struct {
+        TAILQ_ENTRY(vpage_t) entries; // position in the window or SLRU queue
+    } tinylfu; // pages TinyLFU hands to a wrapped policy use that one's
+    struct {
+        ul64 lastAccess; // timestamp of the last reference, 0 if none yet
+    } mrc; // not a policy, see mrc.h
+    struct {
+        ul64 line; // of the next reference to the page seen so far, 0 if none
+    } nextUse; // not a policy either, see first_pass_nextUse
+} ReplaceMeta;
+
 typedef struct vpage_t {
     // VIRTUAL page identified by <VPN, PID>
     ul64 vpn; // virtual page number
     ul64 pid; // process id
+    ResidentSet* owner; // frames of the owning process, or NULL if untracked
 
-    void* overhead; // for replacement policy
+    ReplaceMeta meta; // for replacement policy
 
     // page has a PHYSICAL location as well
     bool inMemory;
@@ -44,72 +108,84 @@ typedef struct ppage_t {
     VPage* virtualPage;
 } PPage;
 
-// allocated once we know the amount of pages (=pmem/pgsize)
+// Physical memory of one simulation, allocated once we know the amount of
+// pages (=pmem/pgsize)
+typedef struct memory_t {
+    PPage** memory;  // a representation of physical memory
+    size_t mem_size; // holds memory size in pages
+    size_t allocated; // holds the number of allocated pages
+
+    // Hierarchical bitmap of free pages. freelist[0] has a 1 at the position
+    // given by the PPN if that page is free; a bit of freelist[l + 1] is 1 if
+    // the 64-bit word of freelist[l] under it has any 1s. The top level is a
+    // single word, so a free page is found with one ctz per level.
+    freelist_t freelist[MEMORY_MAX_LEVELS];
+    int levels;
+} Memory;
 
 /**
- * Initialize Memory module.
+ * Initialize a Memory.
  * @param numberOfPhysicalPages amount of physical memory/page size
  */
-void Memory_init(size_t numberOfPhysicalPages);
+void Memory_init(Memory* m, size_t numberOfPhysicalPages);
+
+/**
+ * Frees a Memory's pages. Virtual pages still loaded are left as they are.
+ */
+void Memory_free(Memory* m);
 
 /**
  * Accesses the physical page with a given ppn
  * @param ppn index into memory
  * @return PPage if present, NULL if not
  */
-PPage* Memory_getPPage(ul64 ppn);
+PPage* Memory_getPPage(Memory* m, ul64 ppn);
 
 /**
  * Accesses the virtual page with a given ppn
  */
-VPage* Memory_getVPage(ul64 ppn);
+VPage* Memory_getVPage(Memory* m, ul64 ppn);
 
 /**
  * Frees the page at a given ppn by sending the virtual page to backing store
  */
-void Memory_evictPage(ul64 ppn);
+void Memory_evictPage(Memory* m, ul64 ppn);
 
 /**
  * Load a page in to memory
  * @return none
  */
-void Memory_loadPage(VPage* virtualPage, ul64 ppn);
+void Memory_loadPage(Memory* m, VPage* virtualPage, ul64 ppn);
 
 /**
  * @return the ppn of the next free page
  */
-ul64 Memory_getFreePage();
+ul64 Memory_getFreePage(Memory* m);
 
 /**
  * @return true if there is a free page in memory
  */
-bool Memory_hasFreePage();
+bool Memory_hasFreePage(Memory* m);
 
 /**
  * @return the number of allocated pages, given by the allocated variable.
  */
-int Memory_howManyAllocPages();
+int Memory_howManyAllocPages(Memory* m);
 
 /**
  * @return the size of memory in pages
  */
-int Memory_getTotalSize();
+int Memory_getTotalSize(Memory* m);
 
 /**
  * Constructs a new Virtual Page given it's virtual identifier
+ * @param arena arena of the owning process, which the page lives in
  * @param pid process id
  * @param vpn virtual page number
- * @param initOverhead function that returns pointer to overhead struct to store
- * in vpage.
- * Interface for initOverhead must match
- * ```C
- * Overhead* initOverhead(ul64 pid, ul64 vpn);
- * ```
+ * @param owner resident set the page counts toward while loaded, or NULL
  * @return pointer to new VPage struct.
  */
-VPage* VPage_init(ul64 pid, ul64 vpn);
-
-void VPage_free(VPage* vp);
+VPage* VPage_init(Arena* arena, ul64 pid, ul64 vpn, ResidentSet* owner);
 
 // Page_destroy()
 
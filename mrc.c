@@ -0,0 +1,328 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file mrc.c
+ * @brief One-pass LRU miss ratio curve, see mrc.h.
+ */
+#define _GNU_SOURCE
+
+#include "mrc.h"
+#include "alloc.h"
+#include "memory.h"
+#include "pagetable.h"
+#include "replace.h"
+
+#include <assert.h>
+#include <search.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    MRC_FIRST_CAPACITY = 1 << 16, // timestamps before the first renumbering
+    MRC_MAX_CHECKS = 12,          // memory sizes replayed by --mrc-check
+};
+
+// The page table of one pid, found by tsearch
+typedef struct mrc_process_t {
+    unsigned long pid;
+    Arena arena; // holds the page table and its VPages
+    PageTable* pageTable;
+} MrcProcess;
+
+// Every process seen so far in one pass over the trace
+typedef struct mrc_processes_t {
+    void* tree;
+    MrcProcess* last; // runs of references share a pid, so cache the last one
+} MrcProcesses;
+
+static Pool mrcProcessPool = POOL_INITIALIZER("MrcProcess", MrcProcess);
+
+// Stack distance histogram, and the Fenwick tree it is counted with
+typedef struct mrc_curve_t {
+    long* fenwick;   // 1 at each page's last access timestamp, 1-based
+    size_t capacity; // timestamps the tree can hold
+    ul64 now;        // last timestamp handed out
+
+    VPage** pages; // every page referenced so far
+    size_t numPages;
+    size_t pagesCapacity;
+
+    unsigned long* hist; // hist[d]: references at stack distance d
+    unsigned long references;
+} MrcCurve;
+
+// === PROCESSES ===
+
+static int Mrc_comparePid(const void* l, const void* r) {
+    const MrcProcess* lp = l;
+    const MrcProcess* rp = r;
+    return (lp->pid > rp->pid) - (lp->pid < rp->pid);
+}
+
+/** @return the page table of a pid, creating it on its first reference */
+static PageTable* Mrc_pageTable(MrcProcesses* ps, unsigned long pid) {
+    if (ps->last != NULL && ps->last->pid == pid) return ps->last->pageTable;
+
+    MrcProcess key = {.pid = pid};
+    MrcProcess** found = tfind(&key, &ps->tree, Mrc_comparePid);
+    if (found == NULL) {
+        MrcProcess* p = Pool_alloc(&mrcProcessPool);
+        p->pid = pid;
+        Arena_init(&p->arena);
+        p->pageTable = PageTable_init(&p->arena, NULL);
+        found = tsearch(p, &ps->tree, Mrc_comparePid);
+        if (found == NULL) {
+            perror("Error searching for pid holder node.");
+            exit(EXIT_FAILURE);
+        }
+    }
+    ps->last = *found;
+    return ps->last->pageTable;
+}
+
+/** Frees a process, for tdestroy */
+static void Mrc_freeProcess(void* node) {
+    MrcProcess* p = node;
+    PageTable_release(p->pageTable);
+    Arena_release(&p->arena);
+    Pool_free(&mrcProcessPool, p);
+}
+
+/** Reads the next reference, failing on the invalid pid 0 like first_pass */
+static bool Mrc_next(Trace* trace, unsigned long line, unsigned long* pid,
+                     unsigned long* vpn) {
+    *pid = 0;
+    if (!Trace_next(trace, pid, vpn)) return false;
+    if (*pid == 0) {
+        fprintf(stderr, "ERROR: Invalid trace file format at line %ld", line);
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+// === FENWICK TREE ===
+
+static inline void Mrc_fenwickAdd(MrcCurve* c, size_t i, long delta) {
+    for (; i <= c->capacity; i += i & -i) c->fenwick[i] += delta;
+}
+
+/** @return number of pages last accessed at or before timestamp i */
+static inline long Mrc_fenwickPrefix(const MrcCurve* c, size_t i) {
+    long sum = 0;
+    for (; i > 0; i -= i & -i) sum += c->fenwick[i];
+    return sum;
+}
+
+static int Mrc_compareLastAccess(const void* l, const void* r) {
+    ul64 a = (*(VPage* const*)l)->meta.mrc.lastAccess;
+    ul64 b = (*(VPage* const*)r)->meta.mrc.lastAccess;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Renumbers the pages' last accesses 1..numPages, keeping their order, and
+ * rebuilds the tree with room for at least as many references again.
+ */
+static void Mrc_renumber(MrcCurve* c) {
+    if (c->numPages > 0) {
+        qsort(c->pages, c->numPages, sizeof(VPage*), Mrc_compareLastAccess);
+    }
+    for (size_t i = 0; i < c->numPages; i++) {
+        c->pages[i]->meta.mrc.lastAccess = i + 1;
+    }
+    c->now = c->numPages;
+
+    size_t capacity = MRC_FIRST_CAPACITY;
+    while (capacity < 2 * c->numPages) capacity *= 2;
+    if (capacity != c->capacity) {
+        free(c->fenwick);
+        c->fenwick = malloc((capacity + 1) * sizeof(long));
+        if (c->fenwick == NULL) {
+            perror("Error allocating memory for stack distance tree.");
+            exit(EXIT_FAILURE);
+        }
+        c->capacity = capacity;
+    }
+
+    // node i covers (i - lowbit(i), i], which holds a page up to numPages
+    c->fenwick[0] = 0;
+    for (size_t i = 1; i <= capacity; i++) {
+        size_t low = i - (i & -i);
+        size_t high = i < c->numPages ? i : c->numPages;
+        c->fenwick[i] = high > low ? (long)(high - low) : 0;
+    }
+}
+
+// === CURVE ===
+
+/** Records a page's first reference, a miss in memory of any size */
+static void Mrc_addPage(MrcCurve* c, VPage* v) {
+    if (c->numPages == c->pagesCapacity) {
+        c->pagesCapacity = c->pagesCapacity ? 2 * c->pagesCapacity : 1024;
+        c->pages = realloc(c->pages, c->pagesCapacity * sizeof(VPage*));
+        // distances go up to the number of pages
+        unsigned long* hist =
+          realloc(c->hist, (c->pagesCapacity + 1) * sizeof(unsigned long));
+        if (c->pages == NULL || hist == NULL) {
+            perror("Error allocating memory for stack distances.");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t d = c->numPages + 1; d <= c->pagesCapacity; d++) {
+            hist[d] = 0;
+        }
+        c->hist = hist;
+    }
+    c->pages[c->numPages++] = v;
+}
+
+/** Records one reference to v */
+static inline void Mrc_reference(MrcCurve* c, VPage* v) {
+    if (c->now == c->capacity) Mrc_renumber(c);
+    ul64 last = v->meta.mrc.lastAccess;
+
+    if (last == 0) {
+        Mrc_addPage(c, v);
+    } else {
+        // pages used since, plus this one
+        size_t d = c->numPages - Mrc_fenwickPrefix(c, last) + 1;
+        c->hist[d]++;
+        Mrc_fenwickAdd(c, last, -1);
+    }
+
+    v->meta.mrc.lastAccess = ++c->now;
+    Mrc_fenwickAdd(c, c->now, 1);
+    c->references++;
+}
+
+/** @return LRU faults with a given number of frames, from the histogram */
+static unsigned long Mrc_faults(const MrcCurve* c, size_t frames) {
+    unsigned long faults = c->numPages; // cold misses
+    for (size_t d = frames + 1; d <= c->numPages; d++) faults += c->hist[d];
+    return faults;
+}
+
+// === CHECK ===
+
+/**
+ * Runs the trace, in file order, through the LRU replacement policy with a
+ * given amount of memory.
+ * @return faults
+ */
+static unsigned long Mrc_replayLRU(Trace* trace, int frames) {
+    Memory memory;
+    Replace replace;
+    MrcProcesses ps = {NULL, NULL};
+    Memory_init(&memory, frames);
+    ReplaceSpec lru = {.policy = REPLACE_LRU, .seed = 1, .name = "lru"};
+    Replace_init(&replace, &lru, &memory);
+
+    unsigned long faults = 0;
+    unsigned long pid;
+    unsigned long vpn;
+    Trace_rewind(trace);
+    for (unsigned long line = 1; Mrc_next(trace, line, &pid, &vpn); line++) {
+        bool inMemory;
+        VPage* v =
+          PageTable_getOrInsert(Mrc_pageTable(&ps, pid), pid, vpn, &inMemory);
+        if (inMemory) {
+            Replace_notifyPageAccess(&replace, v);
+            continue;
+        }
+
+        faults++;
+        unsigned long ppn;
+        Replace_notifyPageFault(&replace, v);
+        if (Memory_hasFreePage(&memory)) {
+            ppn = Memory_getFreePage(&memory);
+        } else {
+            ppn = Replace_getPageToEvict(&replace);
+            Replace_notifyPageEvict(&replace, Memory_getVPage(&memory, ppn));
+            Memory_evictPage(&memory, ppn);
+        }
+        Memory_loadPage(&memory, v, ppn);
+        Replace_notifyPageLoad(&replace, v);
+    }
+
+    // pages go back before their tables do
+    for (int ppn = 0; ppn < frames; ppn++) {
+        VPage* v = Memory_getVPage(&memory, ppn);
+        if (v == NULL) continue;
+        Replace_notifyPageEvict(&replace, v);
+        Memory_evictPage(&memory, ppn);
+    }
+    tdestroy(ps.tree, Mrc_freeProcess);
+    Replace_free(&replace);
+    Memory_free(&memory);
+    return faults;
+}
+
+/**
+ * Replays the trace through LRU at the -m size, and at sizes growing by 4x up
+ * to the number of pages, comparing with the curve.
+ * @return true if every size matched
+ */
+static bool Mrc_check(Trace* trace, const MrcCurve* c, int frames) {
+    int sizes[MRC_MAX_CHECKS];
+    int n = 0;
+    sizes[n++] = frames;
+    for (size_t s = 1; s < c->numPages && n < MRC_MAX_CHECKS - 1; s *= 4) {
+        if ((int)s != frames) sizes[n++] = s;
+    }
+    int all = c->numPages; // enough for every page
+    if (all > 0 && all != frames) sizes[n++] = all;
+
+    bool ok = true;
+    for (int i = 0; i < n; i++) {
+        unsigned long expected = Mrc_faults(c, sizes[i]);
+        unsigned long actual = Mrc_replayLRU(trace, sizes[i]);
+        printf("  LRU check at %i frames: %lu faults, %s\n", sizes[i], actual,
+               actual == expected ? "matches" : "MISMATCH");
+        if (actual != expected) ok = false;
+    }
+    return ok;
+}
+
+// === MAIN ===
+
+void Mrc_run(Trace* trace, int pagesize, int frames, bool check) {
+    assert(trace != NULL && frames > 0);
+    MrcCurve c = {0};
+    MrcProcesses ps = {NULL, NULL};
+    Mrc_renumber(&c); // sets up the tree
+
+    unsigned long pid;
+    unsigned long vpn;
+    Trace_adviseSequential(trace, true);
+    Trace_rewind(trace);
+    for (unsigned long line = 1; Mrc_next(trace, line, &pid, &vpn); line++) {
+        bool inMemory;
+        Mrc_reference(&c, PageTable_getOrInsert(Mrc_pageTable(&ps, pid), pid,
+                                                vpn, &inMemory));
+    }
+
+    // the curve only steps down at distances something was referenced at
+    printf("\x1B[1m\x1B[7m%s\x1B[0m\n", " MISS RATIO CURVE ");
+    printf("  references: %lu\n", c.references);
+    printf("  distinct pages: %zu\n", c.numPages);
+    printf("  %10s %12s %14s %12s\n", "frames", "MB", "faults", "miss ratio");
+    unsigned long faults = c.references;
+    for (size_t d = 1; d <= c.numPages; d++) {
+        if (c.hist[d] == 0) continue;
+        faults -= c.hist[d];
+        printf("  %10zu %12.3f %14lu %12f\n", d,
+               (double)d * pagesize / 0x100000, faults,
+               c.references ? (double)faults / c.references : 0.0);
+    }
+    unsigned long atFrames = Mrc_faults(&c, frames);
+    printf("  \x1B[96mat %i frames:\x1B[0m %lu faults\n", frames, atFrames);
+
+    bool ok = !check || Mrc_check(trace, &c, frames);
+
+    tdestroy(ps.tree, Mrc_freeProcess);
+    free(c.fenwick);
+    free(c.pages);
+    free(c.hist);
+    if (!ok) {
+        fprintf(stderr, "ERROR: LRU fault counts don't match the curve.\n");
+        exit(EXIT_FAILURE);
+    }
+}
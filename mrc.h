@@ -0,0 +1,37 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file mrc.h
+ * @brief Exact LRU miss ratio curve in one pass over the trace (--mrc).
+ * @details Uses Mattson's stack algorithm: LRU with c frames holds exactly the
+ * c most recently used pages, so a reference hits in every memory of at least
+ * its stack distance (the number of distinct pages used since the page's
+ * last use, itself included) and misses in every smaller one. One histogram
+ * of stack distances therefore gives the fault count for every memory size.
+ *
+ * Distances are counted with a Fenwick tree over access timestamps holding a
+ * 1 at each page's last access, so a reference costs O(log n). Timestamps are
+ * renumbered whenever the tree fills up, which keeps it proportional to the
+ * number of distinct pages rather than the length of the trace.
+ *
+ * The curve is for the trace in file order. The simulator interleaves
+ * processes differently as they block on the disk, and frees a process's
+ * frames when it finishes, so pfsim-lru's fault counts can differ slightly.
+ */
+
+#ifndef _MRC_
+#define _MRC_
+
+#include "trace_reader.h"
+#include <stdbool.h>
+
+/**
+ * Computes and prints the LRU miss ratio curve of a trace.
+ * @param trace trace opened with Trace_open; read from the start
+ * @param pagesize page size in bytes, to label the curve in MB
+ * @param frames memory size given with -m, in pages, to report separately
+ * @param check if true, also replays the trace through the LRU policy at
+ * several memory sizes and fails if its fault counts don't match the curve
+ */
+void Mrc_run(Trace* trace, int pagesize, int frames, bool check);
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file pagetable.c
+ * @brief VPN->VPage maps: an open-addressing (linear probing) hash table and
+ * a multi-level radix table, see pagetable.h.
+ */
+
+#include "pagetable.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    PAGETABLE_INITIAL_CAPACITY = 64, // hash slots, power of two
+    RADIX_FANOUT = 1 << PAGETABLE_RADIX_BITS,
+    RADIX_MASK = RADIX_FANOUT - 1,
+};
+
+// set once by PageTable_configure, before any process exists
+static PageTableKind kind = PAGETABLE_HASH;
+static int radixLevels = PAGETABLE_RADIX_DEFAULT_LEVELS;
+
+void PageTable_configure(PageTableKind k, int levels) {
+    if (k == PAGETABLE_RADIX
+        && (levels < 1 || levels > PAGETABLE_RADIX_MAX_LEVELS)) {
+        fprintf(stderr, "ERROR: radix page table must have 1 to %d levels\n",
+                PAGETABLE_RADIX_MAX_LEVELS);
+        exit(EXIT_FAILURE);
+    }
+    kind = k;
+    radixLevels = levels;
+}
+
+// === HASH ===
+
+/**
+ * Fibonacci hashing: multiplies by 2^64 / golden ratio and keeps the top
+ * log2(capacity) bits, which spreads runs of consecutive VPNs evenly over
+ * the table.
+ * @return home slot of vpn in a table of the given capacity, a power of two
+ * of at least 2
+ */
+static inline size_t PageTable_hash(ul64 vpn, size_t capacity) {
+    assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+    uint64_t h = (uint64_t)vpn * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t)(h >> (64 - __builtin_ctzll(capacity)));
+}
+
+static PageTableEntry* PageTable_allocSlots(size_t capacity) {
+    PageTableEntry* slots = calloc(capacity, sizeof(PageTableEntry));
+    if (slots == NULL) {
+        perror("Error allocating memory for page table.");
+        exit(EXIT_FAILURE);
+    }
+    return slots;
+}
+
+/**
+ * Finds the slot holding vpn, or the empty slot where it belongs.
+ */
+static inline PageTableEntry* PageTable_probe(const PageTable* pt, ul64 vpn) {
+    size_t mask = pt->hash.capacity - 1;
+    size_t i = PageTable_hash(vpn, pt->hash.capacity);
+    while (pt->hash.slots[i].page != NULL && pt->hash.slots[i].vpn != vpn) {
+        i = (i + 1) & mask;
+    }
+    return &pt->hash.slots[i];
+}
+
+/** Doubles the number of slots and reinserts every entry */
+static void PageTable_grow(PageTable* pt) {
+    PageTableEntry* old = pt->hash.slots;
+    size_t oldCapacity = pt->hash.capacity;
+
+    pt->hash.capacity *= 2;
+    pt->hash.slots = PageTable_allocSlots(pt->hash.capacity);
+    pt->bytes += oldCapacity * sizeof(PageTableEntry);
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].page != NULL) *PageTable_probe(pt, old[i].vpn) = old[i];
+    }
+    free(old);
+}
+
+/** @return the slot vpn's page goes in, growing the table if needed */
+static inline VPage** PageTable_hashSlot(PageTable* pt, ul64 vpn) {
+    PageTableEntry* e = PageTable_probe(pt, vpn);
+    if (e->page != NULL) return &e->page;
+
+    // keep the load factor at or under 3/4 so probe runs stay short
+    if ((pt->count + 1) * 4 > pt->hash.capacity * 3) {
+        PageTable_grow(pt);
+        e = PageTable_probe(pt, vpn);
+    }
+    e->vpn = vpn;
+    return &e->page;
+}
+
+// === RADIX ===
+
+static void** PageTable_allocRadixTable(PageTable* pt) {
+    void** table = Arena_alloc(pt->arena, RADIX_FANOUT * sizeof(void*));
+    pt->bytes += RADIX_FANOUT * sizeof(void*);
+    return table;
+}
+
+/**
+ * Walks down to the leaf table covering vpn, checking the cached leaf first.
+ * @param create allocate missing tables on the way down
+ * @return the leaf table, or NULL if it doesn't exist and create is false
+ */
+static inline VPage** PageTable_radixLeaf(PageTable* pt, ul64 vpn,
+                                          bool create) {
+    ul64 tag = vpn >> PAGETABLE_RADIX_BITS;
+    if (pt->radix.leaf != NULL && pt->radix.leafTag == tag) {
+        return pt->radix.leaf;
+    }
+
+    int levels = pt->radix.levels;
+    int vpnBits = levels * PAGETABLE_RADIX_BITS;
+    if (vpnBits < 64 && (vpn >> vpnBits) != 0) {
+        if (!create) return NULL;
+        fprintf(stderr,
+                "ERROR: VPN %lu does not fit in a %d level radix page table\n",
+                vpn, levels);
+        exit(EXIT_FAILURE);
+    }
+
+    if (pt->radix.root == NULL) {
+        if (!create) return NULL;
+        pt->radix.root = PageTable_allocRadixTable(pt);
+    }
+    void** table = pt->radix.root;
+    for (int level = levels - 1; level > 0; level--) {
+        size_t i = (vpn >> (level * PAGETABLE_RADIX_BITS)) & RADIX_MASK;
+        if (table[i] == NULL) {
+            if (!create) return NULL;
+            table[i] = PageTable_allocRadixTable(pt);
+        }
+        table = table[i];
+    }
+
+    pt->radix.leafTag = tag;
+    pt->radix.leaf = (VPage**)table;
+    return pt->radix.leaf;
+}
+
+/** Calls fn on every VPage under a radix table */
+static void PageTable_forEachRadix(void** table, int level,
+                                   void (*fn)(VPage* v, void* arg),
+                                   void* arg) {
+    for (size_t i = 0; i < RADIX_FANOUT; i++) {
+        if (table[i] == NULL) continue;
+        if (level == 0) {
+            fn(table[i], arg);
+        } else {
+            PageTable_forEachRadix(table[i], level - 1, fn, arg);
+        }
+    }
+}
+
+// === COMMON ===
+
+PageTable* PageTable_init(Arena* arena, ResidentSet* owner) {
+    PageTable* pt = Arena_alloc(arena, sizeof(PageTable));
+    pt->kind = kind;
+    pt->arena = arena;
+    pt->owner = owner;
+    pt->count = 0;
+    pt->bytes = sizeof(PageTable);
+
+    switch (kind) {
+        case PAGETABLE_HASH:
+            pt->hash.capacity = PAGETABLE_INITIAL_CAPACITY;
+            pt->hash.slots = PageTable_allocSlots(pt->hash.capacity);
+            pt->bytes += pt->hash.capacity * sizeof(PageTableEntry);
+            break;
+        case PAGETABLE_RADIX:
+            pt->radix.root = NULL;
+            pt->radix.levels = radixLevels;
+            pt->radix.leafTag = 0;
+            pt->radix.leaf = NULL;
+            break;
+    }
+    return pt;
+}
+
+VPage* PageTable_get(PageTable* pt, ul64 vpn, bool* inMemory) {
+    assert(pt != NULL);
+    VPage* v = NULL;
+    switch (pt->kind) {
+        case PAGETABLE_HASH:
+            v = PageTable_probe(pt, vpn)->page;
+            break;
+        case PAGETABLE_RADIX: {
+            VPage** leaf = PageTable_radixLeaf(pt, vpn, false);
+            if (leaf != NULL) v = leaf[vpn & RADIX_MASK];
+            break;
+        }
+    }
+    if (inMemory != NULL) *inMemory = v != NULL && v->inMemory;
+    return v;
+}
+
+VPage* PageTable_getOrInsert(PageTable* pt, ul64 pid, ul64 vpn,
+                             bool* inMemory) {
+    assert(pt != NULL && inMemory != NULL);
+    VPage** slot = NULL;
+    switch (pt->kind) {
+        case PAGETABLE_HASH:
+            slot = PageTable_hashSlot(pt, vpn);
+            break;
+        case PAGETABLE_RADIX:
+            slot = &PageTable_radixLeaf(pt, vpn, true)[vpn & RADIX_MASK];
+            break;
+    }
+
+    if (*slot != NULL) {
+        *inMemory = (*slot)->inMemory;
+        return *slot;
+    }
+    *slot = VPage_init(pt->arena, pid, vpn, pt->owner);
+    pt->count++;
+    *inMemory = false;
+    return *slot;
+}
+
+size_t PageTable_bytes(const PageTable* pt) { return pt->bytes; }
+
+void PageTable_forEach(PageTable* pt, void (*fn)(VPage* v, void* arg),
+                       void* arg) {
+    switch (pt->kind) {
+        case PAGETABLE_HASH:
+            for (size_t i = 0; i < pt->hash.capacity; i++) {
+                if (pt->hash.slots[i].page != NULL) {
+                    fn(pt->hash.slots[i].page, arg);
+                }
+            }
+            break;
+        case PAGETABLE_RADIX:
+            if (pt->radix.root != NULL) {
+                PageTable_forEachRadix(pt->radix.root, pt->radix.levels - 1,
+                                       fn, arg);
+            }
+            break;
+    }
+}
+
+void PageTable_release(PageTable* pt) {
+    if (pt == NULL) return;
+    if (pt->kind == PAGETABLE_HASH) {
+        free(pt->hash.slots);
+        pt->hash.slots = NULL;
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file pagetable.h
+ * @brief Per-process map of VPN->VPage. Two structures are available, picked
+ * once at startup with PageTable_configure:
+ *  - hash: a flat open-addressing hash table. Slots hold the VPN next to the
+ *    VPage pointer, so a probe only touches the slot array until it finds the
+ *    matching VPN. Pages are never removed before the process quits, so there
+ *    are no tombstones. Good for sparse address spaces.
+ *  - radix: an x86-style tree of 512-entry tables, indexed 9 VPN bits per
+ *    level, with tables allocated on first touch. Lookups are a fixed number
+ *    of array indexings, and the last leaf used is cached, so sequential
+ *    scans mostly skip the walk. Good for dense address spaces.
+ * Everything but the hash slot array, which is reallocated as it grows, lives
+ * in the owning process's arena.
+ */
+
+#ifndef _PAGETABLE_
+#define _PAGETABLE_
+
+#include "memory.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum PageTableKind {
+    PAGETABLE_HASH = 0,
+    PAGETABLE_RADIX = 1,
+} PageTableKind;
+
+enum {
+    PAGETABLE_RADIX_BITS = 9, // VPN bits per radix level, as on x86-64
+    PAGETABLE_RADIX_DEFAULT_LEVELS = 4, // 36-bit VPNs, a 48-bit address space
+    PAGETABLE_RADIX_MAX_LEVELS = 7,
+};
+
+// One slot of the hash table, empty when page is NULL
+typedef struct page_table_entry_t {
+    ul64 vpn;
+    VPage* page;
+} PageTableEntry;
+
+typedef struct page_table_t {
+    PageTableKind kind;
+    Arena* arena; // owning process's, for VPages and radix tables
+    ResidentSet* owner; // owning process's, given to its VPages
+    size_t count; // number of pages mapped
+    size_t bytes; // memory held by the table itself, not counting VPages
+
+    union {
+        struct {
+            PageTableEntry* slots;
+            size_t capacity; // number of slots, always a power of two
+        } hash;
+        struct {
+            void** root;  // top level table, NULL until the first insert
+            int levels;
+            ul64 leafTag; // vpn >> PAGETABLE_RADIX_BITS of the cached leaf
+            VPage** leaf; // last leaf table walked to, or NULL
+        } radix;
+    };
+} PageTable;
+
+/**
+ * Picks the structure every later PageTable_init builds.
+ * @param kind hash or radix
+ * @param levels radix levels, 1 to PAGETABLE_RADIX_MAX_LEVELS; VPNs must fit
+ * in levels * PAGETABLE_RADIX_BITS bits. Ignored for hash tables.
+ */
+void PageTable_configure(PageTableKind kind, int levels);
+
+/**
+ * Constructs an empty page table of the configured kind (hash by default).
+ * @param arena arena of the owning process, which the table and its VPages
+ * are allocated from
+ * @param owner resident set of the owning process, for its VPages, or NULL
+ */
+PageTable* PageTable_init(Arena* arena, ResidentSet* owner);
+
+/**
+ * Looks up a VPN without allocating anything.
+ * @param[out] inMemory if not NULL, set to whether the page is resident
+ * @return the page, or NULL if the process has never referenced vpn
+ */
+VPage* PageTable_get(PageTable* pt, ul64 vpn, bool* inMemory);
+
+/**
+ * Looks up a VPN, creating its VPage on first reference. This is the one
+ * call the simulator makes per memory reference.
+ * @param pid owner of the table, stored in a newly created VPage
+ * @param[out] inMemory set to whether the page is resident (false if new)
+ * @return the page, never NULL
+ */
+VPage* PageTable_getOrInsert(PageTable* pt, ul64 pid, ul64 vpn,
+                             bool* inMemory);
+
+/**
+ * @return bytes of memory held by the table's own structure, excluding the
+ * VPages it maps, for comparing structures on a given trace
+ */
+size_t PageTable_bytes(const PageTable* pt);
+
+/**
+ * Calls fn on every VPage in a page table, in no particular order.
+ * @param arg passed through to fn
+ */
+void PageTable_forEach(PageTable* pt, void (*fn)(VPage* v, void* arg),
+                       void* arg);
+
+/**
+ * Frees the hash slots of a page table. The rest, including the VPages, goes
+ * when the owning arena is released. No VPage may still be in memory.
+ */
+void PageTable_release(PageTable* pt);
+
+#endif
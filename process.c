@@ -2,30 +2,51 @@
 
 #include "process.h"
 #include "memory.h"
-#include "replace.h"
 #include <assert.h>
-#include <search.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-typedef struct node_t {
-    /* Callers expect this to be the first element in the structure - do not
-       move!  */
-    const void* key;
-    uintptr_t left_node; /* Includes whether the node is red in low-bit. */
-    uintptr_t right_node;
-} * node;
+void ProcessQueues_init(ProcessQueues* q) {
+    STAILQ_INIT(&q->pq[RUNNABLE]); // should only ever have one element
+    STAILQ_INIT(&q->pq[BLOCKED]);  // waiting on disk
+    STAILQ_INIT(&q->pq[FINISHED]);
+    q->processes = (Pool)POOL_INITIALIZER("Process", Process);
+}
 
-static STAILQ_HEAD(processQueue_t, process_t) pq[NUM_OF_PROCESS_STATUSES];
+/**
+ * Fills empty queues with clones of every process in src, which must not have
+ * started running, for another simulation over the same trace.
+ */
+void ProcessQueues_clone(ProcessQueues* dst, const ProcessQueues* src) {
+    assert(STAILQ_EMPTY(&dst->pq[RUNNABLE]));
+    assert(STAILQ_EMPTY(&src->pq[BLOCKED]));
+    assert(STAILQ_EMPTY(&src->pq[FINISHED]));
+    Process* p;
+    STAILQ_FOREACH(p, &src->pq[RUNNABLE], procs) Process_clone(dst, p);
+}
 
-void ProcessQueues_init() {
-    STAILQ_INIT(&pq[RUNNABLE]); // should only ever have one element
-    STAILQ_INIT(&pq[BLOCKED]);  // waiting on disk
-    STAILQ_INIT(&pq[FINISHED]);
+/**
+ * Quits every process left in the queues and frees the process pool. Clones
+ * of these processes must be freed first.
+ */
+void ProcessQueues_free(ProcessQueues* q) {
+    for (int s = 0; s < NUM_OF_PROCESS_STATUSES; s++) {
+        while (!STAILQ_EMPTY(&q->pq[s])) {
+            Process_quit(STAILQ_FIRST(&q->pq[s]));
+        }
+    }
+    Pool_destroy(&q->processes);
 }
 
-/** Insert to a sorted priority queue*/
+/**
+ * Insert to a sorted priority queue, ordered by the trace line each process
+ * resumes at.
+ * @details currentline is only stale for the running head, and then only
+ * within its current interval, which no other process has lines in, so this
+ * orders the same as comparing trace positions would.
+ */
 static void ProcessQueue_enqueuePriority(Process* p, struct processQueue_t* q) {
     assert(p != NULL && q != NULL);
 
@@ -41,7 +62,7 @@ static void ProcessQueue_enqueuePriority(Process* p, struct processQueue_t* q) {
     // iterate until past spot- but prev will still be the element before
     STAILQ_FOREACH(curr, q, procs) {
         assert(curr->pid != p->pid);
-        if (curr->currentPos > p->currentPos) break;
+        if (curr->currentline > p->currentline) break;
         prev = curr;
     }
 
@@ -54,7 +75,7 @@ static void ProcessQueue_enqueuePriority(Process* p, struct processQueue_t* q) {
 
 
 static void ProcessQueue_enqueue(Process* p, struct processQueue_t* q) {
-    if (q == &pq[RUNNABLE]) {
+    if (q == &p->queues->pq[RUNNABLE]) {
         ProcessQueue_enqueuePriority(p, q);
 
     } else {
@@ -62,7 +83,8 @@ static void ProcessQueue_enqueue(Process* p, struct processQueue_t* q) {
     }
 }
 
-void ProcessQueue_printQueue(ProcessStatus q_s) {
+void ProcessQueue_printQueue(ProcessQueues* q, ProcessStatus q_s) {
+    struct processQueue_t* pq = q->pq;
     Process* head = STAILQ_FIRST(&pq[q_s]);
 
     printf("Queue: ");
@@ -100,132 +122,130 @@ void ProcessQueue_printQueue(ProcessStatus q_s) {
 }
 
 
-static PageTable* PageTable_init() {
-    PageTable* pt;
-    if ((pt = (PageTable*)malloc(sizeof(PageTable))) == NULL) {
-        perror("Error allocating memory for page table.");
-        exit(EXIT_FAILURE);
-    }
-    return pt;
-}
-
-static int PageTable_compare(const void* vp1, const void* vp2) {
-    VPage* vp1_page = (VPage*)vp1;
-    VPage* vp2_page = (VPage*)vp2;
-    if (vp1_page->vpn < vp2_page->vpn) {
-        return -1;
-    } else if (vp1_page->vpn > vp2_page->vpn) {
-        return 1;
-    } else {
-        return 0;
-    }
-}
-
-static VPage* PageTable_get(PageTable* pt, unsigned long vpn) {
-    VPage* search_query;
-    VPage* search_result;
-
-    search_query = VPage_init(0, vpn);
-
-    if ((search_result = tfind(search_query, pt, PageTable_compare)) == NULL) {
-        VPage_free(search_query);
-        return NULL;
-    } else {
-        return *(VPage**)search_result;
-    }
-}
-
-static int PageTable_add(PageTable* pt, VPage* new) {
-    VPage* search_result;
-    VPage* temp_result;
-
-    if ((search_result = tsearch(new, pt, PageTable_compare)) == NULL) {
-        perror("Error in page table lookup.");
-        exit(EXIT_FAILURE);
-    } else {
-        temp_result = *(VPage**)search_result;
-
-        if (temp_result != new) {
-            return 1; // collision with existing
-        } else {
-            return 0; // success
-        }
-    }
-}
-
 /**
  * Peek at the proc. at the head of a given status queue. NULL if none present.
  */
-Process* Process_peek(ProcessStatus status) {
-    return STAILQ_FIRST(&pq[status]);
+Process* Process_peek(ProcessQueues* q, ProcessStatus status) {
+    return STAILQ_FIRST(&q->pq[status]);
 }
 
 /**
  * @return true if there is a process in the specified status queue, else false.
  */
-bool Process_existsWithStatus(ProcessStatus status) {
-    return !(STAILQ_EMPTY(&pq[status]));
+bool Process_existsWithStatus(ProcessQueues* q, ProcessStatus status) {
+    return !(STAILQ_EMPTY(&q->pq[status]));
 }
 
 /**
  * Constructs a new Process and initializes internal fields.
+ * @param q queues of the simulation the process belongs to
  * @param pid pid of new process
  * @param firstline first line number in tracefile corresponding to this proc.
- * @param lastline last line number in tracefile corresponding to this proc.
- * @param lineIntervals interval tree overhead
+ * @param lastline last line of this proc.'s first run of lines
+ * @param fpos trace position of firstline
  */
-Process* Process_init(unsigned long pid, unsigned long firstline,
-                      unsigned long lastline, IntervalNode* lineIntervals) {
-    Process* p = malloc(sizeof(Process));
-    if (p == NULL) {
-        perror("Couldn't allocate memory for new process.");
-        exit(EXIT_FAILURE);
-    }
+Process* Process_init(ProcessQueues* q, unsigned long pid,
+                      unsigned long firstline, unsigned long lastline,
+                      long fpos) {
+    Process* p = Pool_alloc(&q->processes);
+    Arena_init(&p->arena);
+
+    IntervalNode* lineIntervals = it_placenode(
+      Arena_alloc(&p->arena, sizeof(IntervalNode)), firstline, lastline);
+    it_setFpos(lineIntervals, fpos);
+
     p->pid = pid;
     p->firstline = firstline;
     p->currentline = firstline;
     p->lastline = lastline;
     p->waitTime = 0;
+    p->wakeTime = 0;
     p->waitingOnPage = NULL;
+    p->loadedPage = NULL;
+    p->frames = (ResidentSet){0};
+    p->faults = 0;
     p->lineIntervals = lineIntervals;
 
     p->currentPos = lineIntervals->fpos_start;
     p->currInterval = lineIntervals;
 
-    p->pageTable = PageTable_init();
+    p->refs = (RefColumn){NULL, 0, 0, NULL};
+    p->nextRef = 0;
+
+    p->pageTable = PageTable_init(&p->arena, &p->frames);
+    p->clone = false;
+    p->queues = q;
     p->status = RUNNABLE;
-    STAILQ_INSERT_TAIL(&pq[RUNNABLE], p, procs);
+    STAILQ_INSERT_TAIL(&q->pq[RUNNABLE], p, procs);
+
+    return p;
+}
+
+/**
+ * Copies a process that hasn't started running into another simulation's
+ * queues. The copy shares the original's intervals and RefColumn, which
+ * are read-only once the first pass is done, and gets its own page table.
+ * @param q queues to add the copy to, at the tail of RUNNABLE
+ * @param src process to copy; must outlive the copy
+ */
+Process* Process_clone(ProcessQueues* q, const Process* src) {
+    assert(src->status == RUNNABLE && src->currentline == src->firstline);
+    Process* p = Pool_alloc(&q->processes);
+    *p = *src;
+
+    Arena_init(&p->arena);
+    p->pageTable = PageTable_init(&p->arena, &p->frames);
+    p->clone = true;
+    p->queues = q;
+    STAILQ_INSERT_TAIL(&q->pq[RUNNABLE], p, procs);
 
     return p;
 }
 
+/**
+ * Adds another run of lines to a process, after all of its earlier runs.
+ * @param firstline first line number of the run
+ * @param lastline last line number of the run
+ * @param fpos trace position of firstline
+ */
+void Process_addInterval(Process* p, unsigned long firstline,
+                         unsigned long lastline, long fpos) {
+    IntervalNode* n = it_placenode(
+      Arena_alloc(&p->arena, sizeof(IntervalNode)), firstline, lastline);
+    it_setFpos(n, fpos);
+    it_insert(p->lineIntervals, n);
+    if (p->lastline < lastline) p->lastline = lastline;
+}
+
 /**
  * Changes the status of a Process to status.
  * @param p pointer to target process
  * @param status new status to assign
  */
 void Process_setStatus(Process* p, ProcessStatus status) {
-    STAILQ_REMOVE(&pq[p->status], p, process_t, procs);
+    STAILQ_REMOVE(&p->queues->pq[p->status], p, process_t, procs);
     p->status = status;
-    ProcessQueue_enqueue(p, &pq[status]);
+    ProcessQueue_enqueue(p, &p->queues->pq[status]);
 }
 
 /**
  * Pops the Process at the head of the s1 queue and enqueues it on the s2 queue.
  * Faster than setStatus because it doesn't need to search.
+ * @param q queues of the simulation
  * @param s1 source status
  * @param s2 destination status
  * @return the process that was moved, or null if none found in s1 queue
  */
-Process* Process_switchStatus(ProcessStatus s1, ProcessStatus s2) {
-    Process* p = STAILQ_FIRST(&pq[s1]);
+Process* Process_switchStatus(ProcessQueues* q, ProcessStatus s1,
+                              ProcessStatus s2) {
+    Process* p = STAILQ_FIRST(&q->pq[s1]);
     if (p == NULL) {
         perror("WARN: Impossible switch, no process on source queue.");
         return NULL;
     }
-    STAILQ_REMOVE_HEAD(&pq[s1], procs);
+    STAILQ_REMOVE_HEAD(&q->pq[s1], procs);
     p->status = s2;
-    ProcessQueue_enqueue(p, &pq[s2]);
+    ProcessQueue_enqueue(p, &q->pq[s2]);
     return p;
 }
 
@@ -288,32 +308,44 @@ inline void Process_jumpToNextInterval(Process* p) {
 }
 
 VPage* Process_allocVirtualPage(Process* p, unsigned long vpn) {
-    VPage* v = VPage_init(p->pid, vpn);
-    PageTable_add(p->pageTable, v);
-    return v;
+    bool inMemory;
+    return PageTable_getOrInsert(p->pageTable, p->pid, vpn, &inMemory);
 }
 
 VPage* Process_getVirtualPage(Process* p, unsigned long vpn) {
     assert(p != NULL);
-    return PageTable_get(p->pageTable, vpn);
+    return PageTable_get(p->pageTable, vpn, NULL);
 }
 
-bool Process_virtualPageInMemory(Process* p, unsigned long vpn) {
-    VPage* v = PageTable_get(p->pageTable, vpn);
-    if (v == NULL) return false;
-    return v->inMemory;
+/**
+ * Looks up the page a process references, creating it on first reference.
+ * @param[out] inMemory whether the page is resident, from the same lookup
+ */
+VPage* Process_referenceVirtualPage(Process* p, unsigned long vpn,
+                                    bool* inMemory) {
+    assert(p != NULL);
+    return PageTable_getOrInsert(p->pageTable, p->pid, vpn, inMemory);
 }
 
-void PageTable_free_destroyVPage(void* vp_node) {
-    VPage* vp = vp_node;
-    VPage_free(vp);
+bool Process_virtualPageInMemory(Process* p, unsigned long vpn) {
+    bool inMemory;
+    PageTable_get(p->pageTable, vpn, &inMemory);
+    return inMemory;
 }
 
+/**
+ * Destructs a process and everything it owns, unlinking it from its queue.
+ * @details its pages must already be out of memory (see Simulator)
+ */
 void Process_quit(Process* p) {
     assert(p->pageTable != NULL);
-    PageTable* pagetable_tmp = p->pageTable;
+    PageTable_release(p->pageTable);
+    p->pageTable = NULL;
+    Arena_release(&p->arena); // page table, VPages and intervals in one go
+    if (!p->clone) RefColumn_free(&p->refs); // clones share the original's
 
-    tdestroy(*pagetable_tmp, PageTable_free_destroyVPage);
+    // unlink from its status queue, so the queue never points at freed memory
+    STAILQ_REMOVE(&p->queues->pq[p->status], p, process_t, procs);
     Process_free(p);
     p = NULL;
 
@@ -324,4 +356,33 @@ void Process_quit(Process* p) {
  * Destructs and frees a Process.
  * @param p pointer to heap-alloc'd process
  */
-void Process_free(Process* p) { free(p); }
+void Process_free(Process* p) { Pool_free(&p->queues->processes, p); }
+
+/**
+ * Appends VPNs to the end of a column, growing it geometrically.
+ * @param c column to append to
+ * @param vpns VPNs to copy in, in trace order
+ * @param n number of VPNs
+ */
+void RefColumn_append(RefColumn* c, const unsigned long* vpns, size_t n) {
+    if (c->length + n > c->capacity) {
+        size_t capacity = c->capacity ? c->capacity : 64;
+        while (capacity < c->length + n) capacity *= 2;
+        unsigned long* grown = realloc(c->vpns, capacity * sizeof(*grown));
+        if (grown == NULL) {
+            perror("Couldn't allocate memory for reference column.");
+            exit(EXIT_FAILURE);
+        }
+        c->vpns = grown;
+        c->capacity = capacity;
+    }
+    memcpy(c->vpns + c->length, vpns, n * sizeof(*vpns));
+    c->length += n;
+}
+
+/** Releases a column's storage and leaves it empty */
+void RefColumn_free(RefColumn* c) {
+    free(c->vpns);
+    free(c->nextUse);
+    *c = (RefColumn){NULL, 0, 0, NULL};
+}
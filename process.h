@@ -1,4 +1,6 @@
 #include "memory.h"
+#include "pagetable.h"
+#include <limits.h>
 #include <stdio.h>
 #include <sys/queue.h>
 
@@ -12,7 +14,28 @@ typedef enum ProcessStatus {
     NUM_OF_PROCESS_STATUSES = 3,
 } ProcessStatus;
 
-typedef void* PageTable;
+STAILQ_HEAD(processQueue_t, process_t);
+
+// The process queues of one simulation, and the pool their processes are
+// allocated from
+typedef struct process_queues_t {
+    struct processQueue_t pq[NUM_OF_PROCESS_STATUSES];
+    Pool processes;
+} ProcessQueues;
+
+// the next use of a page that is never referenced again
+#define REF_NEVER ULONG_MAX
+
+// A process's VPNs in trace order, decoded once by the first pass so the
+// simulation never has to go back to the trace (columnar mode, -c)
+typedef struct ref_column_t {
+    unsigned long* vpns;
+    size_t length;
+    size_t capacity;
+    // trace line of the next reference to each reference's page, or
+    // REF_NEVER; NULL unless filled in by first_pass_nextUse
+    unsigned long* nextUse;
+} RefColumn;
 
 // Represents a process
 typedef struct process_t {
@@ -21,46 +44,67 @@ typedef struct process_t {
     // Queue overhead
     STAILQ_ENTRY(process_t) procs;
     ProcessStatus status;
+    ProcessQueues* queues; // the queues this process is in
 
     // Process's location in the file
     size_t firstline;
     size_t currentline;
     size_t lastline;
-    long currentPos;
+    long currentPos; // trace position of currentline, see trace_reader.h
     IntervalNode* currInterval;
     IntervalNode* lineIntervals;
 
+    // Columnar mode only, empty otherwise
+    RefColumn refs;
+    size_t nextRef; // index in refs of currentline's reference
+
     // Wait info
     unsigned long waitTime; // timer for a disk operation in ticks
+    unsigned long wakeTime; // time the disk operation completes, in ns
     VPage* waitingOnPage;
+    VPage* loadedPage; // loaded for currentline, which hasn't run again yet
 
-    // Map of VPN->PPN
-    PageTable pageTable;
-} Process;
+    // Paging behaviour; frames.virtualTime counts the lines run
+    ResidentSet frames;
+    unsigned long faults;
 
-void ProcessQueues_init(); // global static variable manages process states
+    // Map of VPN->VPage
+    PageTable* pageTable;
 
-void ProcessQueue_printQueue(ProcessStatus q_s);
+    // Holds the page table, VPages and interval nodes, freed all at once
+    Arena arena;
+
+    // True for a copy made by Process_clone, which shares lineIntervals and
+    // refs with the original and only owns its page table
+    bool clone;
+} Process;
 
-int ProcessQueue_numWaitingProcs();
+void ProcessQueues_init(ProcessQueues* q);
+void ProcessQueues_clone(ProcessQueues* dst, const ProcessQueues* src);
+void ProcessQueues_free(ProcessQueues* q);
+
+void ProcessQueue_printQueue(ProcessQueues* q, ProcessStatus q_s);
 
 // Use of BSD tail queue based on queue(3) manpage
 // and "Minimal example of TAILQ usage out of <sys/queue.h> library"
 // (https://stackoverflow.com/q/22315213/11639533)
 
-Process* Process_init();
-
-Process* Process_init(unsigned long pid, unsigned long firstline,
-                      unsigned long lastline, IntervalNode* lineIntervals);
+Process* Process_init(ProcessQueues* q, unsigned long pid,
+                      unsigned long firstline, unsigned long lastline,
+                      long fpos);
+Process* Process_clone(ProcessQueues* q, const Process* src);
+void Process_addInterval(Process* p, unsigned long firstline,
+                         unsigned long lastline, long fpos);
 
-Process* Process_peek(ProcessStatus status);
+Process* Process_peek(ProcessQueues* q, ProcessStatus status);
 
 void Process_quit(Process* p);
 
-bool Process_existsWithStatus(ProcessStatus status);
+bool Process_existsWithStatus(ProcessQueues* q, ProcessStatus status);
 
 void Process_setStatus(Process* p, ProcessStatus status);
-Process* Process_switchStatus(ProcessStatus s1, ProcessStatus s2);
+Process* Process_switchStatus(ProcessQueues* q, ProcessStatus s1,
+                              ProcessStatus s2);
 
 bool Process_hasLinesRemainingInFile(const Process* p);
 bool Process_hasLinesRemainingInInterval(const Process* p);
@@ -71,9 +115,13 @@ void Process_jumpToNextInterval(Process* p);
 
 VPage* Process_allocVirtualPage(Process* p, unsigned long vpn);
 VPage* Process_getVirtualPage(Process* p, unsigned long vpn);
+VPage* Process_referenceVirtualPage(Process* p, unsigned long vpn,
+                                    bool* inMemory);
 bool Process_virtualPageInMemory(Process* p, unsigned long vpn);
-unsigned long Process_loadVirtualPage(Process* p, unsigned long vpn);
 
 void Process_free(Process* p);
 
+void RefColumn_append(RefColumn* c, const unsigned long* vpns, size_t n);
+void RefColumn_free(RefColumn* c);
+
 #endif
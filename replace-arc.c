@@ -0,0 +1,45 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-arc.c
+ * @brief Replacement module implementing ARC (Adaptive Replacement Cache).
+ * Overhead is tied to virtual pages for resident pages, and lives in them;
+ * evicted pages are remembered in a ghost table sized to physical memory.
+ * @details the per-reference hooks are inline, in replace-arc.h
+ */
+
+#include "replace-arc.h"
+#include <stdio.h>
+#include <sys/queue.h>
+
+void ReplaceARC_init(ReplaceARC* r, int numberOfPhysicalPages) {
+    TAILQ_INIT(&r->t1);
+    TAILQ_INIT(&r->t2);
+    r->t1Pages = 0;
+    r->t2Pages = 0;
+    r->capacity = numberOfPhysicalPages;
+    r->target = 0;
+    // |B1| + |B2| <= c whenever a victim is remembered, see notifyPageFault
+    Ghost_init(&r->ghosts, numberOfPhysicalPages);
+    r->incomingFrequent = false;
+    r->incomingFromB2 = false;
+    r->forgetVictim = false;
+    r->victim = NULL;
+    r->b1Hits = 0;
+    r->b2Hits = 0;
+}
+
+void ReplaceARC_free(ReplaceARC* r) {
+    assert(r->t1Pages >= 0 && r->t2Pages >= 0);
+    assert(r->t1Pages + r->t2Pages <= r->capacity);
+    Ghost_free(&r->ghosts);
+    TAILQ_INIT(&r->t1);
+    TAILQ_INIT(&r->t2);
+    r->t1Pages = 0;
+    r->t2Pages = 0;
+}
+
+void ReplaceARC_printStats(const ReplaceARC* r) {
+    printf("  \x1B[96marc ghost hits:\x1B[0m %lu in B1, %lu in B2; "
+           "T1 target %i of %i frames\n",
+           r->b1Hits, r->b2Hits, r->target, r->capacity);
+}
@@ -0,0 +1,171 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-arc.h
+ * @brief Inline hooks of ARC, the Adaptive Replacement Cache (Megiddo and
+ * Modha, FAST '03). Resident pages are split between T1, pages seen once
+ * recently, and T2, pages seen at least twice, both in LRU order. Ghost lists
+ * B1 and B2 remember the <pid, vpn> of pages recently evicted from each, and
+ * a hit on a ghost moves the target size p of T1 toward the list that would
+ * have kept it. Scans only ever pass through T1, so they can't flush a hot
+ * working set out of T2.
+ * @details Resident pages are linked into T1 or T2 through VPage.meta.arc;
+ * ghosts are keys in a Ghost table bounded to the number of frames (see
+ * ghost.h), which is as many as ARC ever keeps.
+ */
+
+#ifndef _REPLACE_ARC_
+#define _REPLACE_ARC_
+
+#include "ghost.h"
+#include "memory.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <sys/queue.h>
+
+// ghost lists
+enum { ARC_B1, ARC_B2 };
+
+/**
+ * ARC Queues
+ *  - least recently used items are on the head of each queue
+ *  - based on a doubly-linked tail queue
+ */
+TAILQ_HEAD(arc_queue_t, vpage_t);
+
+typedef struct replace_arc_t {
+    struct arc_queue_t t1; // resident, seen once
+    struct arc_queue_t t2; // resident, seen at least twice
+    int t1Pages;
+    int t2Pages;
+    int capacity; // size of physical memory, c
+    int target;   // p, the size T1 is steered toward, 0..c
+    Ghost ghosts; // B1 and B2
+
+    // the page being faulted in, as classified by ReplaceARC_notifyPageFault
+    bool incomingFrequent; // it was a ghost, so it goes to T2
+    bool incomingFromB2;
+    bool forgetVictim; // the victim goes without leaving a ghost
+    VPage* victim;     // picked by ReplaceARC_getPageToEvict
+
+    // counters
+    unsigned long b1Hits;
+    unsigned long b2Hits;
+} ReplaceARC;
+
+/** Initializes empty lists, with room for one ghost per frame */
+void ReplaceARC_init(ReplaceARC* r, int numberOfPhysicalPages);
+
+/** Frees the ghost table; the resident lists are made of the pages */
+void ReplaceARC_free(ReplaceARC* r);
+
+/** Prints ghost hits and the final target size of T1 */
+void ReplaceARC_printStats(const ReplaceARC* r);
+
+/**
+ * A hit moves the page to the most recently used end of T2
+ * @details O(1)
+ */
+static inline void ReplaceARC_notifyPageAccess(ReplaceARC* r, VPage* v) {
+    assert(v->inMemory);
+    if (v->meta.arc.frequent) {
+        TAILQ_REMOVE(&r->t2, v, meta.arc.entries);
+    } else {
+        TAILQ_REMOVE(&r->t1, v, meta.arc.entries);
+        r->t1Pages--;
+        r->t2Pages++;
+        v->meta.arc.frequent = true;
+    }
+    TAILQ_INSERT_TAIL(&r->t2, v, meta.arc.entries);
+}
+
+/**
+ * A page is about to be loaded. A ghost hit adapts the target, otherwise the
+ * ghost lists are trimmed as in ARC's case IV, so that |T1| + |B1| <= c and
+ * all four lists together hold at most 2c pages.
+ * @details O(1)
+ */
+static inline void ReplaceARC_notifyPageFault(ReplaceARC* r, VPage* v) {
+    int b1 = Ghost_count(&r->ghosts, ARC_B1);
+    int b2 = Ghost_count(&r->ghosts, ARC_B2);
+    int list = Ghost_remove(&r->ghosts, v->pid, v->vpn);
+
+    r->incomingFrequent = list != GHOST_NONE;
+    r->incomingFromB2 = list == ARC_B2;
+    r->forgetVictim = false;
+    if (list == ARC_B1) { // T1 was too small
+        int delta = b1 >= b2 ? 1 : b2 / b1;
+        r->target = r->target + delta < r->capacity ? r->target + delta
+                                                    : r->capacity;
+        r->b1Hits++;
+    } else if (list == ARC_B2) { // T2 was too small
+        int delta = b2 >= b1 ? 1 : b1 / b2;
+        r->target = r->target > delta ? r->target - delta : 0;
+        r->b2Hits++;
+    } else if (r->t1Pages + b1 >= r->capacity) {
+        if (r->t1Pages < r->capacity) {
+            Ghost_dropOldest(&r->ghosts, ARC_B1);
+        } else {
+            r->forgetVictim = true; // T1 alone fills memory, B1 is empty
+        }
+    } else if (r->t1Pages + r->t2Pages + b1 + b2 >= 2 * r->capacity) {
+        Ghost_dropOldest(&r->ghosts, ARC_B2);
+    }
+}
+
+/**
+ * Enqueue page to T2 if it was a ghost, T1 otherwise
+ * @details O(1)
+ */
+static inline void ReplaceARC_notifyPageLoad(ReplaceARC* r, VPage* v) {
+    assert(v->inMemory);
+    v->meta.arc.frequent = r->incomingFrequent;
+    if (r->incomingFrequent) {
+        TAILQ_INSERT_TAIL(&r->t2, v, meta.arc.entries);
+        r->t2Pages++;
+    } else {
+        TAILQ_INSERT_TAIL(&r->t1, v, meta.arc.entries);
+        r->t1Pages++;
+    }
+    r->incomingFrequent = false;
+}
+
+/**
+ * Remove page from its list. A victim becomes a ghost of the matching list;
+ * pages of finished processes are simply dropped.
+ * @details O(1)
+ */
+static inline void ReplaceARC_notifyPageEvict(ReplaceARC* r, VPage* v) {
+    assert(v->inMemory);
+    if (v->meta.arc.frequent) {
+        TAILQ_REMOVE(&r->t2, v, meta.arc.entries);
+        r->t2Pages--;
+    } else {
+        TAILQ_REMOVE(&r->t1, v, meta.arc.entries);
+        r->t1Pages--;
+    }
+    if (v == r->victim) {
+        if (!r->forgetVictim) {
+            Ghost_push(&r->ghosts, v->meta.arc.frequent ? ARC_B2 : ARC_B1,
+                       v->pid, v->vpn);
+        }
+        r->victim = NULL;
+    }
+}
+
+/**
+ * ARC's REPLACE: the LRU page of T1 if T1 is over its target (or at it, when
+ * the incoming page was a B2 ghost), else the LRU page of T2
+ * @details O(1)
+ * @return PPN of page to evict
+ */
+static inline unsigned long ReplaceARC_getPageToEvict(ReplaceARC* r) {
+    assert(r->t1Pages + r->t2Pages > 0);
+    bool fromT1 = r->t1Pages > 0
+                  && (r->t1Pages > r->target
+                      || (r->incomingFromB2 && r->t1Pages == r->target)
+                      || r->t2Pages == 0);
+    r->victim = fromT1 ? TAILQ_FIRST(&r->t1) : TAILQ_FIRST(&r->t2);
+    return r->victim->currentPPN;
+}
+
+#endif
@@ -2,89 +2,79 @@
  * CS 537 Programming Assignment 4 (Fall 2020)
  * @file replace-clock.c
  * @brief Replacement module implementing the Clock algorithm.
- * Overhead is tied to physical pages in the form of a shadow array on memory, for
- * reference bits.
+ * Overhead is tied to physical pages in the form of a shadow bitmap on memory,
+ * for reference bits.
  * @author Julien de Castelnau
- * @details Note that overhead is still needed to update said reference bits 
- * upon successful hits, for which the only information we have is the VPN which 
- * just got a hit.
+ * @details the per-reference hooks are inline, in replace-clock.h
  */
 
-#include "replace.h"
-#include <assert.h>
+#include "replace-clock.h"
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 
-// Clock doesn't need any overhead information, other than a reference
-// back to its parent VPN so that PPNs can be resolved and used to 
-// make changes to the freelist shadow array.
-struct clock_overhead {
-    VPage* parent;
-};
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define CLOCK_HAVE_AVX2 1
+#endif
 
-// index into memory (freelist), a PPN which indicates where the clock hand currently is
-static unsigned long clock_hand; 
-// size of memory in pages
-static int numPages;
-// a shadow array of memory, which stores reference bits for each page frame.
-static bool* shadowMem_Reflist;
+// memories with fewer bitmap words than this sweep full words one at a time;
+// runs of set words are too short there for vectors to pay off
+enum { CLOCK_AVX2_MIN_WORDS = 256 }; // 16384 frames
 
-// Creates shadow array, initializes clock_hand to 0
-void Replace_initReplacementModule(int numberOfPhysicalPages) {
-    clock_hand = 0;
-    numPages = numberOfPhysicalPages;
-    if ((shadowMem_Reflist = (bool*)malloc(sizeof(bool) * numPages)) == NULL) {
-        perror("Cannot allocate memory for clock algorithm shadow rarray.");
-    }
+/** Clears set words one at a time */
+static size_t ReplaceClock_skipFull_scalar(uint64_t* refs, size_t from,
+                                           size_t words) {
+    size_t w = from;
+    while (w < words && refs[w] == ~(uint64_t)0) refs[w++] = 0;
+    return w;
 }
 
-void Replace_freeReplacementModule() { 
-    free(shadowMem_Reflist);    
+#ifdef CLOCK_HAVE_AVX2
+/** Clears set words four at a time while they are all set */
+__attribute__((target("avx2"))) static size_t
+ReplaceClock_skipFull_avx2(uint64_t* refs, size_t from, size_t words) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t w = from;
+    while (w + 4 <= words) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(refs + w));
+        if (!_mm256_testc_si256(v, ones)) break; // some bit is 0
+        _mm256_storeu_si256((__m256i*)(refs + w), _mm256_setzero_si256());
+        w += 4;
+    }
+    return ReplaceClock_skipFull_scalar(refs, w, words);
 }
+#endif
 
-/**
- * Need to set the parent pointer in the overhead.
- * @param VPage* caller/parent VPage
- * @return a pointer to the newly allocated overhead struct
- */
-void* Replace_initOverhead(VPage* vpage) {
-    struct clock_overhead* co =
-      (struct clock_overhead*)malloc(sizeof(struct clock_overhead));
-    co->parent = vpage;
-    return co;
-}
+void ReplaceClock_init(ReplaceClock* r, int numberOfPhysicalPages) {
+    r->hand = 0;
+    r->pages = numberOfPhysicalPages;
+    r->words = (r->pages + 63) / 64;
+    r->refs = calloc(r->words > 0 ? r->words : 1, sizeof(uint64_t));
+    if (r->refs == NULL) {
+        perror("Cannot allocate memory for clock algorithm shadow rarray.");
+        exit(EXIT_FAILURE);
+    }
+    r->evictions = 0;
+    r->travel = 0;
 
-void Replace_freeOverhead(void* o_ptr) {
-    free((struct clock_overhead*)o_ptr);
+    r->skipFull = ReplaceClock_skipFull_scalar;
+#ifdef CLOCK_HAVE_AVX2
+    __builtin_cpu_init();
+    if (r->words >= CLOCK_AVX2_MIN_WORDS && __builtin_cpu_supports("avx2")) {
+        r->skipFull = ReplaceClock_skipFull_avx2;
+    }
+#endif
 }
 
-/**
- * A page was referenced, so we turn the reference bit on.
- * @param o_ptr void* to overhead struct
- */
-void Replace_notifyPageAccess(void* o_ptr) {
-    // We assume the Vpage is in memory because this gets called
-    // after it was just referenced.
-    assert(((struct clock_overhead*)o_ptr)->parent->inMemory);
-    shadowMem_Reflist[((struct clock_overhead*)o_ptr)->parent->currentPPN] =
-      true;
+void ReplaceClock_free(ReplaceClock* r) {
+    free(r->refs);
+    r->refs = NULL;
 }
 
-// unimplemented
-void Replace_notifyPageLoad(void* o_ptr) { Replace_notifyPageAccess(o_ptr); }
-
-/**
- * Core clock algorithm. Sweeps through the reference bits till it finds a 0,
- * setting the 1s to 0s on its way.
- * @return PPN of page frame to evict
- */
-unsigned long Replace_getPageToEvict() {
-    assert(!Memory_hasFreePage());
-
-    // loop through until a 0 is found, setting every 1 to 0
-    while (shadowMem_Reflist[clock_hand] == true) {
-        shadowMem_Reflist[clock_hand] = false;
-        clock_hand = (clock_hand + 1) % numPages;
-    }
-    return (clock_hand);
+void ReplaceClock_printStats(const ReplaceClock* r) {
+    printf("  \x1B[96mclock hand travel:\x1B[0m %.2f frames per eviction "
+           "(%lu evictions)\n",
+           r->evictions ? (double)r->travel / r->evictions : 0.0,
+           r->evictions);
 }
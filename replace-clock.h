@@ -0,0 +1,104 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-clock.h
+ * @brief Inline hooks of the Clock algorithm. Reference bits live in a shadow
+ * bitmap on physical memory, indexed by PPN, so pages need no metadata.
+ * @author Julien de Castelnau
+ */
+
+#ifndef _REPLACE_CLOCK_
+#define _REPLACE_CLOCK_
+
+#include "memory.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct replace_clock_t {
+    // index into memory (freelist), a PPN which indicates where the clock hand
+    // currently is
+    unsigned long hand;
+    // size of memory in pages
+    int pages;
+    // a shadow bitmap of memory, which stores the reference bit of each page
+    // frame at bit ppn % 64 of word ppn / 64. Bits past the last frame stay 0.
+    uint64_t* refs;
+    size_t words;
+    // clears a run of all-set words starting at a word, and returns the first
+    // word that isn't all set (or the number of words); scalar or AVX2
+    size_t (*skipFull)(uint64_t* refs, size_t from, size_t words);
+
+    // counters
+    unsigned long evictions;
+    unsigned long travel; // frames the hand moved past, over all evictions
+} ReplaceClock;
+
+/** Creates shadow bitmap, initializes the clock hand to 0 */
+void ReplaceClock_init(ReplaceClock* r, int numberOfPhysicalPages);
+
+/** Frees the shadow bitmap */
+void ReplaceClock_free(ReplaceClock* r);
+
+/** Prints the average hand travel per eviction */
+void ReplaceClock_printStats(const ReplaceClock* r);
+
+/**
+ * A page was referenced, so we turn the reference bit on.
+ */
+static inline void ReplaceClock_notifyPageAccess(ReplaceClock* r, VPage* v) {
+    // We assume the Vpage is in memory because this gets called
+    // after it was just referenced.
+    assert(v->inMemory);
+    r->refs[v->currentPPN / 64] |= (uint64_t)1 << (v->currentPPN % 64);
+}
+
+/** A newly loaded page starts out referenced */
+static inline void ReplaceClock_notifyPageLoad(ReplaceClock* r, VPage* v) {
+    ReplaceClock_notifyPageAccess(r, v);
+}
+
+/** Nothing to do, the frame's bit is overwritten by the next load */
+static inline void ReplaceClock_notifyPageEvict(
+  __attribute__((unused)) ReplaceClock* r, __attribute__((unused)) VPage* v) {}
+
+/**
+ * Core clock algorithm. Sweeps through the reference bits till it finds a 0,
+ * setting the 1s to 0s on its way. Works a word at a time: the first 0 at or
+ * after the hand is found with ctz, the 1s before it are cleared with one
+ * mask, and words that are all 1s are cleared and skipped whole.
+ * @return PPN of page frame to evict
+ */
+static inline unsigned long ReplaceClock_getPageToEvict(ReplaceClock* r) {
+    size_t w = r->hand / 64;
+    uint64_t from = ~(uint64_t)0 << (r->hand % 64); // bits at or after hand
+    r->evictions++;
+    for (;;) {
+        // frames that exist in this word; only the last one is partial
+        uint64_t valid = ~(uint64_t)0;
+        if (w == r->words - 1 && r->pages % 64 != 0) {
+            valid = ((uint64_t)1 << (r->pages % 64)) - 1;
+        }
+        uint64_t swept = from & valid;
+        uint64_t zeros = ~r->refs[w] & swept;
+        if (zeros != 0) {
+            uint64_t before = swept & ((zeros & -zeros) - 1); // passed over
+            r->refs[w] &= ~before;
+            r->travel += __builtin_popcountll(before);
+            r->hand = w * 64 + __builtin_ctzll(zeros);
+            return r->hand;
+        }
+        // every frame left in this word is referenced
+        r->refs[w] &= ~swept;
+        r->travel += __builtin_popcountll(swept);
+        w++;
+        if (w < r->words && r->refs[w] == ~(uint64_t)0) {
+            size_t next = r->skipFull(r->refs, w, r->words);
+            r->travel += (next - w) * 64;
+            w = next;
+        }
+        if (w == r->words) w = 0; // wrap around
+        from = ~(uint64_t)0;
+    }
+}
+
+#endif
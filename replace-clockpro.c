@@ -0,0 +1,294 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-clockpro.c
+ * @brief Replacement module implementing CLOCK-Pro. Overhead is tied to
+ * physical pages in the form of a shadow array of list nodes on memory, plus
+ * one node and one ghost per non-resident page, at most one per frame.
+ * @details see replace-clockpro.h for the algorithm. The cold target starts
+ * at its minimum, like ARC's target for T1, so pages only turn hot once they
+ * prove themselves.
+ */
+
+#include "replace-clockpro.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CLOCKPRO_NIL UINT_MAX
+
+// the one ghost list non-resident pages are kept on
+enum { CLOCKPRO_NONRESIDENT };
+
+static inline bool ReplaceClockPro_isResident(const ReplaceClockPro* r,
+                                              unsigned int n) {
+    return n < (unsigned int)r->pages;
+}
+
+// === LIST ===
+
+/** Takes a node off the list; hands on it move on to the next one */
+static void ReplaceClockPro_unlink(ReplaceClockPro* r, unsigned int n) {
+    assert(r->listed > 0);
+    if (--r->listed == 0) {
+        r->handCold = r->handHot = r->handTest = CLOCKPRO_NIL;
+        return;
+    }
+    ClockProNode* node = &r->nodes[n];
+    if (r->handCold == n) r->handCold = node->next;
+    if (r->handHot == n) r->handHot = node->next;
+    if (r->handTest == n) r->handTest = node->next;
+    r->nodes[node->prev].next = node->next;
+    r->nodes[node->next].prev = node->prev;
+}
+
+/** Puts a node at the head of the list, the last place HAND_hot gets to */
+static void ReplaceClockPro_insertHead(ReplaceClockPro* r, unsigned int n) {
+    ClockProNode* node = &r->nodes[n];
+    if (r->listed++ == 0) {
+        node->prev = node->next = n;
+        r->handCold = r->handHot = r->handTest = n;
+        return;
+    }
+    node->next = r->handHot;
+    node->prev = r->nodes[r->handHot].prev;
+    r->nodes[node->prev].next = n;
+    r->nodes[node->next].prev = n;
+}
+
+/** Puts a node in another's place on the list, hands included */
+static void ReplaceClockPro_replace(ReplaceClockPro* r, unsigned int old,
+                                    unsigned int n) {
+    ClockProNode* node = &r->nodes[n];
+    if (r->listed == 1) {
+        node->prev = node->next = n;
+    } else {
+        node->prev = r->nodes[old].prev;
+        node->next = r->nodes[old].next;
+        r->nodes[node->prev].next = n;
+        r->nodes[node->next].prev = n;
+    }
+    if (r->handCold == old) r->handCold = n;
+    if (r->handHot == old) r->handHot = n;
+    if (r->handTest == old) r->handTest = n;
+}
+
+// === ADAPTATION ===
+
+/** A cold page was re-referenced during its test period */
+static inline void ReplaceClockPro_growCold(ReplaceClockPro* r) {
+    if (r->coldTarget < r->pages) r->coldTarget++;
+}
+
+/** A test period ended without a re-reference */
+static inline void ReplaceClockPro_shrinkCold(ReplaceClockPro* r) {
+    if (r->coldTarget > 1) r->coldTarget--;
+}
+
+/** Forgets a non-resident page, node and ghost */
+static void ReplaceClockPro_removeNonresident(ReplaceClockPro* r,
+                                              unsigned int n) {
+    ReplaceClockPro_unlink(r, n);
+    Ghost_removeEntry(&r->nonresident, n - r->pages);
+}
+
+// === HANDS ===
+
+/**
+ * Runs HAND_hot until it demotes a hot page, clearing the reference bits of
+ * hot pages and ending the test periods of cold pages on its way.
+ */
+static void ReplaceClockPro_runHandHot(ReplaceClockPro* r) {
+    assert(r->hotPages > 0);
+    for (;;) {
+        unsigned int n = r->handHot;
+        ClockProNode* node = &r->nodes[n];
+        r->handHot = node->next;
+        r->hotMoves++;
+        if (!ReplaceClockPro_isResident(r, n)) {
+            ReplaceClockPro_removeNonresident(r, n);
+            ReplaceClockPro_shrinkCold(r);
+        } else if (!node->hot) {
+            if (node->test) {
+                node->test = false;
+                ReplaceClockPro_shrinkCold(r);
+            }
+        } else if (node->ref) {
+            node->ref = false;
+        } else {
+            node->hot = false;
+            r->hotPages--;
+            r->coldPages++;
+            return;
+        }
+    }
+}
+
+/** Runs HAND_hot while hot pages are over their share, m - m_c */
+static inline void ReplaceClockPro_balance(ReplaceClockPro* r) {
+    while (r->hotPages > r->pages - r->coldTarget) {
+        ReplaceClockPro_runHandHot(r);
+    }
+}
+
+/**
+ * Runs HAND_test until it removes a non-resident page, ending the test
+ * periods of cold pages on its way.
+ */
+static void ReplaceClockPro_runHandTest(ReplaceClockPro* r) {
+    assert(Ghost_count(&r->nonresident, CLOCKPRO_NONRESIDENT) > 0);
+    for (;;) {
+        unsigned int n = r->handTest;
+        ClockProNode* node = &r->nodes[n];
+        r->handTest = node->next;
+        r->testMoves++;
+        if (!ReplaceClockPro_isResident(r, n)) {
+            ReplaceClockPro_removeNonresident(r, n);
+            ReplaceClockPro_shrinkCold(r);
+            return;
+        }
+        if (!node->hot && node->test) {
+            node->test = false;
+            ReplaceClockPro_shrinkCold(r);
+        }
+    }
+}
+
+// === HOOKS ===
+
+void ReplaceClockPro_notifyPageFault(ReplaceClockPro* r, VPage* v) {
+    long e = Ghost_find(&r->nonresident, v->pid, v->vpn);
+    r->incomingHot = e != GHOST_NONE;
+    if (r->incomingHot) {
+        ReplaceClockPro_removeNonresident(r, r->pages + e);
+        ReplaceClockPro_growCold(r);
+    }
+}
+
+void ReplaceClockPro_notifyPageLoad(ReplaceClockPro* r, VPage* v) {
+    assert(v->inMemory);
+    unsigned int n = v->currentPPN;
+    r->nodes[n] = (ClockProNode){
+      .hot = r->incomingHot, .ref = false, .test = !r->incomingHot};
+    if (r->incomingHot) {
+        r->hotPages++;
+    } else {
+        r->coldPages++;
+    }
+    r->incomingHot = false;
+    ReplaceClockPro_insertHead(r, n);
+    ReplaceClockPro_balance(r);
+}
+
+void ReplaceClockPro_notifyPageEvict(ReplaceClockPro* r, VPage* v) {
+    assert(v->inMemory);
+    unsigned int n = v->currentPPN;
+    if ((long)n != r->victim) { // its process finished
+        if (r->nodes[n].hot) {
+            r->hotPages--;
+        } else {
+            r->coldPages--;
+        }
+        ReplaceClockPro_unlink(r, n);
+        return;
+    }
+
+    r->victim = -1;
+    r->coldPages--;
+    r->coldMoves++; // past the victim
+    if (r->nodes[n].test
+        && Ghost_count(&r->nonresident, CLOCKPRO_NONRESIDENT)
+             == (size_t)r->pages) {
+        ReplaceClockPro_runHandTest(r); // may end this page's test too
+    }
+    if (!r->nodes[n].test) {
+        ReplaceClockPro_unlink(r, n);
+        return;
+    }
+
+    // still being tested, so it stays on the list without its frame
+    unsigned int e =
+      Ghost_push(&r->nonresident, CLOCKPRO_NONRESIDENT, v->pid, v->vpn);
+    unsigned int m = r->pages + e;
+    r->nodes[m] = (ClockProNode){.hot = false, .ref = false, .test = true};
+    ReplaceClockPro_replace(r, n, m);
+    if (r->handCold == m) r->handCold = r->nodes[m].next;
+}
+
+unsigned long ReplaceClockPro_getPageToEvict(ReplaceClockPro* r) {
+    r->evictions++;
+    ReplaceClockPro_balance(r); // so there is a resident cold page
+    assert(r->coldPages > 0);
+    for (;;) {
+        unsigned int n = r->handCold;
+        ClockProNode* node = &r->nodes[n];
+        if (ReplaceClockPro_isResident(r, n) && !node->hot) {
+            if (!node->ref) {
+                r->victim = n;
+                return n;
+            }
+            r->handCold = node->next;
+            r->coldMoves++;
+            node->ref = false;
+            ReplaceClockPro_unlink(r, n);
+            if (node->test) { // re-referenced during its test period
+                node->hot = true;
+                node->test = false;
+                r->coldPages--;
+                r->hotPages++;
+                ReplaceClockPro_growCold(r);
+                ReplaceClockPro_insertHead(r, n);
+                ReplaceClockPro_balance(r);
+            } else { // re-referenced after it, so test it again
+                node->test = true;
+                ReplaceClockPro_insertHead(r, n);
+            }
+        } else {
+            r->handCold = node->next;
+            r->coldMoves++;
+        }
+    }
+}
+
+// === SETUP ===
+
+void ReplaceClockPro_init(ReplaceClockPro* r, int numberOfPhysicalPages) {
+    r->pages = numberOfPhysicalPages;
+    r->nodes = malloc(2 * (size_t)r->pages * sizeof(ClockProNode));
+    if (r->nodes == NULL) {
+        perror("Cannot allocate memory for CLOCK-Pro list nodes.");
+        exit(EXIT_FAILURE);
+    }
+    Ghost_init(&r->nonresident, r->pages);
+    r->coldTarget = 1;
+    r->hotPages = 0;
+    r->coldPages = 0;
+    r->listed = 0;
+    r->handCold = r->handHot = r->handTest = CLOCKPRO_NIL;
+    r->incomingHot = false;
+    r->victim = -1;
+    r->evictions = 0;
+    r->coldMoves = 0;
+    r->hotMoves = 0;
+    r->testMoves = 0;
+}
+
+void ReplaceClockPro_free(ReplaceClockPro* r) {
+    assert(r->hotPages + r->coldPages <= r->pages);
+    assert((size_t)r->listed
+           == r->hotPages + r->coldPages
+                + Ghost_count(&r->nonresident, CLOCKPRO_NONRESIDENT));
+    free(r->nodes);
+    r->nodes = NULL;
+    Ghost_free(&r->nonresident);
+}
+
+void ReplaceClockPro_printStats(const ReplaceClockPro* r) {
+    double evictions = r->evictions ? r->evictions : 1;
+    printf("  \x1B[96mclockpro hand moves:\x1B[0m %.2f per eviction "
+           "(cold %.2f, hot %.2f, test %.2f; %lu evictions)\n",
+           (r->coldMoves + r->hotMoves + r->testMoves) / evictions,
+           r->coldMoves / evictions, r->hotMoves / evictions,
+           r->testMoves / evictions, r->evictions);
+    printf("  \x1B[96mclockpro cold target:\x1B[0m %i of %i frames\n",
+           r->coldTarget, r->pages);
+}
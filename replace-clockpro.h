@@ -0,0 +1,110 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-clockpro.h
+ * @brief CLOCK-Pro (Jiang, Chen and Zhang, USENIX ATC '05): Clock's hit cost,
+ * one bit set, with scan resistance close to ARC's. Pages are hot or cold.
+ * One circular list holds the resident pages and, for a while after they
+ * leave, cold pages that were evicted during their test period. Three hands
+ * go around it:
+ *  - HAND_cold evicts cold pages that weren't referenced, and promotes the
+ *    ones referenced during their test period to hot;
+ *  - HAND_hot demotes unreferenced hot pages to cold when there are more hot
+ *    pages than its share, and ends the test periods it passes;
+ *  - HAND_test ends test periods too, to keep at most one non-resident page
+ *    per frame.
+ * The share of cold pages adapts: up when a page is re-referenced during its
+ * test period, down when a test period ends without one.
+ * @details Like Clock, state lives in a shadow array on physical memory: the
+ * list node of a resident page is at the index of its PPN. Non-resident
+ * pages take nodes after those, one per entry of a Ghost table (see ghost.h)
+ * that maps <pid, vpn> to them. Only the hit hook is inline; the others walk
+ * the list and are in replace-clockpro.c.
+ */
+
+#ifndef _REPLACE_CLOCKPRO_
+#define _REPLACE_CLOCKPRO_
+
+#include "ghost.h"
+#include "memory.h"
+#include <assert.h>
+#include <stdbool.h>
+
+typedef struct clockpro_node_t {
+    unsigned int prev; // circular list, toward HAND_hot's past
+    unsigned int next; // circular list, the way the hands move
+    bool hot;
+    bool ref;  // reference bit, resident pages only
+    bool test; // in its test period, always true for non-resident pages
+} ClockProNode;
+
+typedef struct replace_clockpro_t {
+    // nodes [0, pages) are resident pages by PPN, [pages, 2 * pages) are
+    // non-resident pages by Ghost entry
+    ClockProNode* nodes;
+    int pages;        // size of memory in pages, m
+    int coldTarget;   // m_c, resident cold pages aimed for, 1..m
+    int hotPages;     // resident hot pages
+    int coldPages;    // resident cold pages
+    int listed;       // nodes on the list
+    Ghost nonresident;
+
+    // hands, nodes on the list; all the same when the list is empty
+    unsigned int handCold;
+    unsigned int handHot;
+    unsigned int handTest;
+
+    bool incomingHot; // the page being faulted in was still being tested
+    long victim;      // PPN picked by ReplaceClockPro_getPageToEvict, or -1
+
+    // counters
+    unsigned long evictions;
+    unsigned long coldMoves;
+    unsigned long hotMoves;
+    unsigned long testMoves;
+} ReplaceClockPro;
+
+/** Creates the node array and the non-resident table, both empty */
+void ReplaceClockPro_init(ReplaceClockPro* r, int numberOfPhysicalPages);
+
+/** Frees the node array and the non-resident table */
+void ReplaceClockPro_free(ReplaceClockPro* r);
+
+/** Prints hand movements per eviction, and the cold target */
+void ReplaceClockPro_printStats(const ReplaceClockPro* r);
+
+/**
+ * A page was referenced, so we turn the reference bit on.
+ */
+static inline void ReplaceClockPro_notifyPageAccess(ReplaceClockPro* r,
+                                                    VPage* v) {
+    assert(v->inMemory);
+    r->nodes[v->currentPPN].ref = true;
+}
+
+/**
+ * Looks the page up among the non-resident ones. If it is there, it was
+ * re-referenced during its test period: the cold target grows, and it comes
+ * back hot.
+ */
+void ReplaceClockPro_notifyPageFault(ReplaceClockPro* r, VPage* v);
+
+/**
+ * Puts the page at the head of the list (just behind HAND_hot), hot if it
+ * was found during its test period and otherwise cold with a test period of
+ * its own, and runs HAND_hot if there are too many hot pages.
+ */
+void ReplaceClockPro_notifyPageLoad(ReplaceClockPro* r, VPage* v);
+
+/**
+ * Takes a page off the list, leaving a non-resident node in its place if it
+ * is the victim and still being tested.
+ */
+void ReplaceClockPro_notifyPageEvict(ReplaceClockPro* r, VPage* v);
+
+/**
+ * Runs HAND_cold to the next cold page without its reference bit.
+ * @return PPN of page to evict
+ */
+unsigned long ReplaceClockPro_getPageToEvict(ReplaceClockPro* r);
+
+#endif
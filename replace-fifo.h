@@ -0,0 +1,75 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-fifo.h
+ * @brief Inline hooks of the FIFO (First In, First Out) policy. Resident pages
+ * are linked straight into the FIFO queue through VPage.meta.fifo.
+ * @author Michael Noguera
+ * @details does not use a singly linked list because that would make removal
+ * O(n)
+ */
+
+#ifndef _REPLACE_FIFO_
+#define _REPLACE_FIFO_
+
+#include "memory.h"
+#include <assert.h>
+#include <sys/queue.h>
+
+/**
+ * FIFO Queue
+ *  - oldest items are on the head of the queue
+ *  - based on a doubly-linked tail queue
+ */
+TAILQ_HEAD(fifo_queue_t, vpage_t);
+
+typedef struct replace_fifo_t {
+    struct fifo_queue_t queue;
+    int pages;    // current size of queue
+    int capacity; // size of physical memory, thus max size of queue
+} ReplaceFIFO;
+
+/** Initializes the FIFO queue */
+void ReplaceFIFO_init(ReplaceFIFO* r, int numberOfPhysicalPages);
+
+/** Nothing to free, the queue is made of the pages themselves */
+void ReplaceFIFO_free(ReplaceFIFO* r);
+
+/**
+ * Does nothing, because FIFO does not adapt based frequency of access
+ */
+static inline void ReplaceFIFO_notifyPageAccess(
+  __attribute__((unused)) ReplaceFIFO* r, __attribute__((unused)) VPage* v) {}
+
+/**
+ * Enqueue page to FIFO queue
+ * @details O(1)
+ */
+static inline void ReplaceFIFO_notifyPageLoad(ReplaceFIFO* r, VPage* v) {
+    assert(v->inMemory);
+    TAILQ_INSERT_TAIL(&r->queue, v, meta.fifo.entries); // tail: newest
+    r->pages++;
+}
+
+/**
+ * Remove page from FIFO queue
+ * @details O(1)
+ */
+static inline void ReplaceFIFO_notifyPageEvict(ReplaceFIFO* r, VPage* v) {
+    assert(v->inMemory && r->pages > 0);
+    TAILQ_REMOVE(&r->queue, v, meta.fifo.entries);
+    r->pages--;
+}
+
+/**
+ * Oldest page in the FIFO queue
+ * @details O(1)
+ * @return PPN of page to evict
+ */
+static inline unsigned long ReplaceFIFO_getPageToEvict(ReplaceFIFO* r) {
+    assert(r->pages > 0);
+
+    // head of queue holds oldest item
+    return TAILQ_FIRST(&r->queue)->currentPPN;
+}
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-lfu.c
+ * @brief Replacement module implementing LFU. Overhead is tied to virtual
+ * pages, and lives in them, plus one pooled bucket per distinct count.
+ * @details the per-reference hooks are inline, in replace-lfu.h
+ */
+
+#include "replace-lfu.h"
+#include <stdio.h>
+#include <sys/queue.h>
+
+void ReplaceLFU_init(ReplaceLFU* r, int numberOfPhysicalPages,
+                     unsigned long period) {
+    TAILQ_INIT(&r->buckets);
+    r->bucketPool = (Pool)POOL_INITIALIZER("LfuBucket", LfuBucket);
+    r->pages = 0;
+    r->capacity = numberOfPhysicalPages;
+    r->period = period;
+    r->sinceDecay = 0;
+    r->decays = 0;
+    r->liveBuckets = 0;
+    r->peakBuckets = 0;
+}
+
+void ReplaceLFU_free(ReplaceLFU* r) {
+    assert(r->pages >= 0 && r->pages <= r->capacity);
+    Pool_destroy(&r->bucketPool);
+    TAILQ_INIT(&r->buckets);
+    r->pages = 0;
+    r->liveBuckets = 0;
+}
+
+void ReplaceLFU_printStats(const ReplaceLFU* r) {
+    if (r->period != 0) {
+        printf("  \x1B[96mlfu decay:\x1B[0m counts halved %lu times, every "
+               "%lu references\n",
+               r->decays, r->period);
+    }
+    printf("  \x1B[96mlfu buckets:\x1B[0m at most %i live\n", r->peakBuckets);
+}
+
+void ReplaceLFU_decay(ReplaceLFU* r) {
+    r->sinceDecay = 0;
+    r->decays++;
+
+    // halving keeps the buckets in order, but neighbours can end up equal
+    LfuBucket* prev = NULL;
+    LfuBucket* b = TAILQ_FIRST(&r->buckets);
+    while (b != NULL) {
+        LfuBucket* next = TAILQ_NEXT(b, buckets);
+        b->count = b->count > 1 ? b->count / 2 : 1;
+        if (prev != NULL && prev->count == b->count) {
+            // after prev's pages, which were referenced less
+            VPage* v;
+            TAILQ_FOREACH(v, &b->pages, meta.lfu.entries) {
+                v->meta.lfu.bucket = prev;
+            }
+            TAILQ_CONCAT(&prev->pages, &b->pages, meta.lfu.entries);
+            ReplaceLFU_dropBucket(r, b);
+        } else {
+            prev = b;
+        }
+        b = next;
+    }
+}
@@ -0,0 +1,161 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-lfu.h
+ * @brief Inline hooks of LFU (Least-Frequently-Used), in the constant-time
+ * layout of Shah, Mitra and Matani: a list of frequency buckets in
+ * increasing order of reference count, each holding the pages referenced
+ * that many times since they were loaded, oldest first. The victim is the
+ * oldest page of the first bucket, and a hit moves a page into the next
+ * bucket, creating it if its count isn't one more, so every hook is O(1).
+ * @details Pages are linked into their bucket through VPage.meta.lfu.
+ * Buckets come from a pool owned by the instance, and go back to it as soon
+ * as they empty, so once as many buckets have been live as ever will be, no
+ * hook allocates. Counts can optionally decay: every period references all
+ * of them are halved (see ReplaceLFU_init), so pages that were hot long
+ * ago age out instead of holding their frames forever. A decay walks every
+ * bucket and merges the ones that end up equal, O(frames) once per period.
+ */
+
+#ifndef _REPLACE_LFU_
+#define _REPLACE_LFU_
+
+#include "alloc.h"
+#include "memory.h"
+#include <assert.h>
+#include <sys/queue.h>
+
+TAILQ_HEAD(lfu_pages_t, vpage_t);
+
+// The resident pages referenced count times
+typedef struct lfu_bucket_t {
+    unsigned long count;
+    struct lfu_pages_t pages; // oldest at the head
+    TAILQ_ENTRY(lfu_bucket_t) buckets;
+} LfuBucket;
+
+// buckets in increasing order of count
+TAILQ_HEAD(lfu_buckets_t, lfu_bucket_t);
+
+typedef struct replace_lfu_t {
+    struct lfu_buckets_t buckets;
+    Pool bucketPool;
+    int pages;    // resident
+    int capacity; // size of physical memory
+
+    unsigned long period; // references between decays, 0 for never
+    unsigned long sinceDecay;
+
+    // counters
+    unsigned long decays;
+    int liveBuckets;
+    int peakBuckets;
+} ReplaceLFU;
+
+/**
+ * Initializes an empty bucket list and its pool
+ * @param period references between halvings of every count, 0 for never
+ */
+void ReplaceLFU_init(ReplaceLFU* r, int numberOfPhysicalPages,
+                     unsigned long period);
+
+/** Gives the bucket pool back to the system */
+void ReplaceLFU_free(ReplaceLFU* r);
+
+/** Prints the decay period and how many buckets were live at once */
+void ReplaceLFU_printStats(const ReplaceLFU* r);
+
+/** Halves every count, merging buckets that end up equal */
+void ReplaceLFU_decay(ReplaceLFU* r);
+
+/** Takes a bucket from the pool and links it in after prev, or first */
+static inline LfuBucket* ReplaceLFU_addBucket(ReplaceLFU* r, LfuBucket* prev,
+                                              unsigned long count) {
+    LfuBucket* b = Pool_alloc(&r->bucketPool);
+    b->count = count;
+    TAILQ_INIT(&b->pages);
+    if (prev == NULL) {
+        TAILQ_INSERT_HEAD(&r->buckets, b, buckets);
+    } else {
+        TAILQ_INSERT_AFTER(&r->buckets, prev, b, buckets);
+    }
+    if (++r->liveBuckets > r->peakBuckets) r->peakBuckets = r->liveBuckets;
+    return b;
+}
+
+/** Unlinks a bucket that just emptied and returns it to the pool */
+static inline void ReplaceLFU_dropBucket(ReplaceLFU* r, LfuBucket* b) {
+    assert(TAILQ_EMPTY(&b->pages));
+    TAILQ_REMOVE(&r->buckets, b, buckets);
+    Pool_free(&r->bucketPool, b);
+    r->liveBuckets--;
+}
+
+/** Counts a reference toward the next decay, if decay is on */
+static inline void ReplaceLFU_tick(ReplaceLFU* r) {
+    if (r->period != 0 && ++r->sinceDecay == r->period) ReplaceLFU_decay(r);
+}
+
+/**
+ * Move page to the tail of the bucket for one more reference
+ * @details O(1)
+ */
+static inline void ReplaceLFU_notifyPageAccess(ReplaceLFU* r, VPage* v) {
+    assert(v->inMemory);
+    LfuBucket* b = v->meta.lfu.bucket;
+    LfuBucket* next = TAILQ_NEXT(b, buckets);
+
+    if (next == NULL || next->count != b->count + 1) {
+        if (TAILQ_FIRST(&b->pages) == v
+            && TAILQ_NEXT(v, meta.lfu.entries) == NULL) {
+            b->count++; // alone in its bucket, which can just move up
+            ReplaceLFU_tick(r);
+            return;
+        }
+        next = ReplaceLFU_addBucket(r, b, b->count + 1);
+    }
+    TAILQ_REMOVE(&b->pages, v, meta.lfu.entries);
+    TAILQ_INSERT_TAIL(&next->pages, v, meta.lfu.entries);
+    v->meta.lfu.bucket = next;
+    if (TAILQ_EMPTY(&b->pages)) ReplaceLFU_dropBucket(r, b);
+    ReplaceLFU_tick(r);
+}
+
+/**
+ * Enqueue page to the tail of the bucket for one reference
+ * @details O(1)
+ */
+static inline void ReplaceLFU_notifyPageLoad(ReplaceLFU* r, VPage* v) {
+    assert(v->inMemory && r->pages < r->capacity);
+    LfuBucket* first = TAILQ_FIRST(&r->buckets);
+    if (first == NULL || first->count != 1) {
+        first = ReplaceLFU_addBucket(r, NULL, 1);
+    }
+    TAILQ_INSERT_TAIL(&first->pages, v, meta.lfu.entries);
+    v->meta.lfu.bucket = first;
+    r->pages++;
+    ReplaceLFU_tick(r);
+}
+
+/**
+ * Remove page from its bucket
+ * @details O(1)
+ */
+static inline void ReplaceLFU_notifyPageEvict(ReplaceLFU* r, VPage* v) {
+    assert(v->inMemory && r->pages > 0);
+    LfuBucket* b = v->meta.lfu.bucket;
+    TAILQ_REMOVE(&b->pages, v, meta.lfu.entries);
+    if (TAILQ_EMPTY(&b->pages)) ReplaceLFU_dropBucket(r, b);
+    r->pages--;
+}
+
+/**
+ * Oldest page of the least referenced bucket
+ * @details O(1)
+ * @return PPN of page to evict
+ */
+static inline unsigned long ReplaceLFU_getPageToEvict(ReplaceLFU* r) {
+    assert(r->pages > 0);
+    return TAILQ_FIRST(&TAILQ_FIRST(&r->buckets)->pages)->currentPPN;
+}
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-lirs.c
+ * @brief Replacement module implementing LIRS. Overhead is tied to physical
+ * pages in the form of a shadow array of stack and queue nodes on memory,
+ * plus one node and one ghost per non-resident page, at most one per frame.
+ * @details see replace-lirs.h for the algorithm. HIR pages get 1% of memory,
+ * and at least one frame, as in the paper.
+ */
+
+#include "replace-lirs.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LIRS_NIL UINT_MAX
+
+enum {
+    LIRS_HIR_PERCENT = 1, // of memory, for resident HIR pages
+};
+
+// the one ghost list non-resident pages are kept on, oldest first
+enum { LIRS_NONRESIDENT };
+
+static inline bool ReplaceLIRS_isResident(const ReplaceLIRS* r,
+                                          unsigned int n) {
+    return n < (unsigned int)r->pages;
+}
+
+// === STACK S ===
+
+static void ReplaceLIRS_push(ReplaceLIRS* r, unsigned int n) {
+    LirsNode* node = &r->nodes[n];
+    node->up = LIRS_NIL;
+    node->down = r->top;
+    if (r->top == LIRS_NIL) {
+        r->bottom = n;
+    } else {
+        r->nodes[r->top].up = n;
+    }
+    r->top = n;
+    node->inStack = true;
+}
+
+static void ReplaceLIRS_unlink(ReplaceLIRS* r, unsigned int n) {
+    LirsNode* node = &r->nodes[n];
+    assert(node->inStack);
+    if (node->up == LIRS_NIL) {
+        r->top = node->down;
+    } else {
+        r->nodes[node->up].down = node->down;
+    }
+    if (node->down == LIRS_NIL) {
+        r->bottom = node->up;
+    } else {
+        r->nodes[node->down].up = node->up;
+    }
+    node->inStack = false;
+}
+
+/** Puts a node in another's place in S */
+static void ReplaceLIRS_replace(ReplaceLIRS* r, unsigned int old,
+                                unsigned int n) {
+    LirsNode* node = &r->nodes[n];
+    node->up = r->nodes[old].up;
+    node->down = r->nodes[old].down;
+    if (node->up == LIRS_NIL) {
+        r->top = n;
+    } else {
+        r->nodes[node->up].down = n;
+    }
+    if (node->down == LIRS_NIL) {
+        r->bottom = n;
+    } else {
+        r->nodes[node->down].up = n;
+    }
+    node->inStack = true;
+    r->nodes[old].inStack = false;
+}
+
+/** Forgets a non-resident page, node and ghost */
+static void ReplaceLIRS_removeNonresident(ReplaceLIRS* r, unsigned int n) {
+    ReplaceLIRS_unlink(r, n);
+    Ghost_removeEntry(&r->nonresident, n - r->pages);
+}
+
+/**
+ * Pops HIR pages off the bottom of S until an LIR page is there. Resident
+ * ones stay in Q; non-resident ones are forgotten.
+ */
+static void ReplaceLIRS_prune(ReplaceLIRS* r) {
+    while (r->bottom != LIRS_NIL && !r->nodes[r->bottom].lir) {
+        unsigned int n = r->bottom;
+        if (ReplaceLIRS_isResident(r, n)) {
+            ReplaceLIRS_unlink(r, n);
+        } else {
+            ReplaceLIRS_removeNonresident(r, n);
+        }
+        r->pruned++;
+    }
+}
+
+void ReplaceLIRS_moveToTop(ReplaceLIRS* r, unsigned int n) {
+    bool wasBottom = r->bottom == n;
+    ReplaceLIRS_unlink(r, n);
+    ReplaceLIRS_push(r, n);
+    if (wasBottom) ReplaceLIRS_prune(r);
+}
+
+// === QUEUE Q ===
+
+static void ReplaceLIRS_enqueue(ReplaceLIRS* r, unsigned int n) {
+    LirsNode* node = &r->nodes[n];
+    node->qnext = LIRS_NIL;
+    node->qprev = r->back;
+    if (r->back == LIRS_NIL) {
+        r->front = n;
+    } else {
+        r->nodes[r->back].qnext = n;
+    }
+    r->back = n;
+}
+
+static void ReplaceLIRS_dequeue(ReplaceLIRS* r, unsigned int n) {
+    LirsNode* node = &r->nodes[n];
+    if (node->qprev == LIRS_NIL) {
+        r->front = node->qnext;
+    } else {
+        r->nodes[node->qprev].qnext = node->qnext;
+    }
+    if (node->qnext == LIRS_NIL) {
+        r->back = node->qprev;
+    } else {
+        r->nodes[node->qnext].qprev = node->qprev;
+    }
+}
+
+// === LIR SET ===
+
+/**
+ * Makes a resident page LIR, at the top of S. If that overfills the LIR set,
+ * the bottom LIR page turns HIR, goes to the back of Q, and S is pruned.
+ */
+static void ReplaceLIRS_makeLIR(ReplaceLIRS* r, unsigned int n) {
+    r->nodes[n].lir = true;
+    ReplaceLIRS_push(r, n);
+    if (++r->lirPages <= r->lirLimit) return;
+
+    unsigned int demoted = r->bottom;
+    assert(demoted != n && r->nodes[demoted].lir);
+    ReplaceLIRS_unlink(r, demoted);
+    r->nodes[demoted].lir = false;
+    r->lirPages--;
+    ReplaceLIRS_enqueue(r, demoted);
+    ReplaceLIRS_prune(r);
+}
+
+// === HOOKS ===
+
+void ReplaceLIRS_accessHIR(ReplaceLIRS* r, unsigned int n) {
+    LirsNode* node = &r->nodes[n];
+    if (node->inStack && r->lirLimit > 0) {
+        // its inter-reference recency beats the bottom LIR page's recency
+        ReplaceLIRS_unlink(r, n);
+        ReplaceLIRS_dequeue(r, n);
+        ReplaceLIRS_makeLIR(r, n);
+        r->promoted++;
+    } else {
+        if (node->inStack) ReplaceLIRS_unlink(r, n);
+        ReplaceLIRS_push(r, n);
+        ReplaceLIRS_dequeue(r, n);
+        ReplaceLIRS_enqueue(r, n);
+    }
+}
+
+void ReplaceLIRS_notifyPageFault(ReplaceLIRS* r, VPage* v) {
+    r->references++;
+    long e = Ghost_find(&r->nonresident, v->pid, v->vpn);
+    r->incomingInStack = e != GHOST_NONE;
+    if (r->incomingInStack) {
+        // never the bottom, which is LIR, so S needs no pruning
+        ReplaceLIRS_removeNonresident(r, r->pages + e);
+    }
+}
+
+void ReplaceLIRS_notifyPageLoad(ReplaceLIRS* r, VPage* v) {
+    assert(v->inMemory);
+    unsigned int n = v->currentPPN;
+    r->nodes[n].lir = false;
+    if (r->incomingInStack && r->lirLimit > 0) {
+        ReplaceLIRS_makeLIR(r, n);
+        r->promoted++;
+    } else if (r->lirPages < r->lirLimit) {
+        ReplaceLIRS_makeLIR(r, n);
+    } else {
+        ReplaceLIRS_push(r, n);
+        ReplaceLIRS_enqueue(r, n);
+    }
+    r->incomingInStack = false;
+}
+
+void ReplaceLIRS_notifyPageEvict(ReplaceLIRS* r, VPage* v) {
+    assert(v->inMemory);
+    unsigned int n = v->currentPPN;
+    LirsNode* node = &r->nodes[n];
+    if ((long)n != r->victim) { // its process finished, forget it entirely
+        if (node->lir) {
+            r->lirPages--;
+        } else {
+            ReplaceLIRS_dequeue(r, n);
+        }
+        if (node->inStack) {
+            bool wasBottom = r->bottom == n;
+            ReplaceLIRS_unlink(r, n);
+            if (wasBottom) ReplaceLIRS_prune(r);
+        }
+        return;
+    }
+
+    r->victim = -1;
+    assert(!node->lir);
+    ReplaceLIRS_dequeue(r, n);
+    if (!node->inStack) return;
+
+    // still in S, so it stays there without its frame
+    if (Ghost_count(&r->nonresident, LIRS_NONRESIDENT) == (size_t)r->pages) {
+        long oldest = Ghost_oldest(&r->nonresident, LIRS_NONRESIDENT);
+        ReplaceLIRS_removeNonresident(r, r->pages + oldest);
+        r->forgotten++;
+    }
+    unsigned int e =
+      Ghost_push(&r->nonresident, LIRS_NONRESIDENT, v->pid, v->vpn);
+    unsigned int m = r->pages + e;
+    r->nodes[m].lir = false;
+    ReplaceLIRS_replace(r, n, m);
+}
+
+unsigned long ReplaceLIRS_getPageToEvict(ReplaceLIRS* r) {
+    assert(r->front != LIRS_NIL && "no resident HIR page");
+    r->victim = r->front;
+    return r->front;
+}
+
+// === SETUP ===
+
+void ReplaceLIRS_init(ReplaceLIRS* r, int numberOfPhysicalPages) {
+    r->pages = numberOfPhysicalPages;
+    r->nodes = malloc(2 * (size_t)r->pages * sizeof(LirsNode));
+    if (r->nodes == NULL) {
+        perror("Cannot allocate memory for LIRS stack nodes.");
+        exit(EXIT_FAILURE);
+    }
+    for (int n = 0; n < 2 * r->pages; n++) r->nodes[n].inStack = false;
+    Ghost_init(&r->nonresident, r->pages);
+
+    int hirPages = r->pages * LIRS_HIR_PERCENT / 100;
+    if (hirPages < 1) hirPages = 1;
+    r->lirLimit = r->pages - hirPages;
+    r->lirPages = 0;
+    r->top = r->bottom = LIRS_NIL;
+    r->front = r->back = LIRS_NIL;
+    r->incomingInStack = false;
+    r->victim = -1;
+    r->references = 0;
+    r->promoted = 0;
+    r->pruned = 0;
+    r->forgotten = 0;
+}
+
+void ReplaceLIRS_free(ReplaceLIRS* r) {
+    assert(r->lirPages >= 0 && r->lirPages <= r->lirLimit);
+    free(r->nodes);
+    r->nodes = NULL;
+    Ghost_free(&r->nonresident);
+}
+
+void ReplaceLIRS_printStats(const ReplaceLIRS* r) {
+    printf("  \x1B[96mlirs LIR set:\x1B[0m %i frames, %lu pages promoted to "
+           "it\n",
+           r->lirLimit, r->promoted);
+    printf("  \x1B[96mlirs pruning:\x1B[0m %.3f entries per reference, %lu "
+           "non-resident pages dropped for room\n",
+           r->references ? (double)r->pruned / r->references : 0.0,
+           r->forgotten);
+}
@@ -0,0 +1,119 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-lirs.h
+ * @brief LIRS, Low Inter-reference Recency Set (Jiang and Zhang, SIGMETRICS
+ * '02). Pages with a low inter-reference recency (LIR) hold most of memory
+ * and are never evicted while they keep it; the rest (HIR) share a few
+ * frames, and are evicted first-in first-out from queue Q. Stack S orders
+ * pages by recency, including HIR pages that were evicted (non-resident), so
+ * that a page referenced again while still in S, more recently than the
+ * oldest LIR page, takes that page's place in the LIR set. Loops bigger than
+ * memory then keep a fixed part of the loop resident, where LRU and Clock
+ * fault on every reference.
+ * @details S is pruned so its bottom is always an LIR page; each entry is
+ * pruned at most once per push, so the cost per reference is amortized O(1).
+ * Like CLOCK-Pro, nodes of resident pages are a shadow array by PPN, and
+ * non-resident pages take nodes after those, one per entry of a Ghost table
+ * (see ghost.h) bounded to the number of frames; when it is full the oldest
+ * non-resident page is dropped from S. Only the hook for hits on LIR pages
+ * is inline; the others are in replace-lirs.c.
+ */
+
+#ifndef _REPLACE_LIRS_
+#define _REPLACE_LIRS_
+
+#include "ghost.h"
+#include "memory.h"
+#include <assert.h>
+#include <stdbool.h>
+
+typedef struct lirs_node_t {
+    unsigned int up;    // S, toward the top (most recent)
+    unsigned int down;  // S, toward the bottom
+    unsigned int qprev; // Q, toward the front (evicted next)
+    unsigned int qnext; // Q, toward the back
+    bool lir;
+    bool inStack;
+} LirsNode;
+
+typedef struct replace_lirs_t {
+    // nodes [0, pages) are resident pages by PPN, [pages, 2 * pages) are
+    // non-resident pages by Ghost entry
+    LirsNode* nodes;
+    int pages;    // size of memory in pages
+    int lirLimit; // L_lirs, frames for LIR pages; the other L_hirs are HIR's
+    int lirPages;
+    Ghost nonresident;
+
+    unsigned int top;    // S
+    unsigned int bottom; // S, an LIR page once pruned
+    unsigned int front;  // Q
+    unsigned int back;   // Q
+
+    bool incomingInStack; // the page being faulted in was non-resident in S
+    long victim;          // PPN picked by ReplaceLIRS_getPageToEvict, or -1
+
+    // counters
+    unsigned long references;
+    unsigned long promoted; // HIR pages that became LIR, resident or not
+    unsigned long pruned;
+    unsigned long forgotten; // non-resident pages dropped for room
+} ReplaceLIRS;
+
+/** Creates the node array and the non-resident table, both empty */
+void ReplaceLIRS_init(ReplaceLIRS* r, int numberOfPhysicalPages);
+
+/** Frees the node array and the non-resident table */
+void ReplaceLIRS_free(ReplaceLIRS* r);
+
+/** Prints LIR set changes and the pruning cost per reference */
+void ReplaceLIRS_printStats(const ReplaceLIRS* r);
+
+/** Moves a node to the top of S, and prunes if it was the bottom */
+void ReplaceLIRS_moveToTop(ReplaceLIRS* r, unsigned int n);
+
+/** A hit on a resident HIR page */
+void ReplaceLIRS_accessHIR(ReplaceLIRS* r, unsigned int n);
+
+/**
+ * A hit on an LIR page moves it to the top of S, like LRU; a hit on an HIR
+ * page still in S makes it LIR in place of the bottom LIR page.
+ * @details amortized O(1)
+ */
+static inline void ReplaceLIRS_notifyPageAccess(ReplaceLIRS* r, VPage* v) {
+    assert(v->inMemory);
+    r->references++;
+    unsigned int n = v->currentPPN;
+    if (r->nodes[n].lir) {
+        if (r->top != n) ReplaceLIRS_moveToTop(r, n);
+    } else {
+        ReplaceLIRS_accessHIR(r, n);
+    }
+}
+
+/**
+ * Looks the page up among the non-resident ones, and takes it out of S if it
+ * is there; it comes back as LIR.
+ */
+void ReplaceLIRS_notifyPageFault(ReplaceLIRS* r, VPage* v);
+
+/**
+ * Pushes the page on S, as LIR if the LIR set isn't full yet or the page was
+ * in S, else as HIR at the back of Q.
+ */
+void ReplaceLIRS_notifyPageLoad(ReplaceLIRS* r, VPage* v);
+
+/**
+ * Takes a page out of S and Q. The victim stays in S, non-resident, if it was
+ * in S.
+ */
+void ReplaceLIRS_notifyPageEvict(ReplaceLIRS* r, VPage* v);
+
+/**
+ * The front of Q, the oldest resident HIR page
+ * @details O(1)
+ * @return PPN of page to evict
+ */
+unsigned long ReplaceLIRS_getPageToEvict(ReplaceLIRS* r);
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-lru.h
+ * @brief Inline hooks of the LRU (Least-Recently-Used) policy. Resident pages
+ * are linked straight into the LRU queue through VPage.meta.lru.
+ * @author Michael Noguera
+ */
+
+#ifndef _REPLACE_LRU_
+#define _REPLACE_LRU_
+
+#include "memory.h"
+#include <assert.h>
+#include <sys/queue.h>
+
+/**
+ * LRU Queue
+ *  - oldest items are on the head of the queue
+ *  - based on a doubly-linked tail queue
+ */
+TAILQ_HEAD(lrq_t, vpage_t);
+
+typedef struct replace_lru_t {
+    struct lrq_t queue;
+    int pages;    // current size of queue
+    int capacity; // size of physical memory, thus max size of queue
+} ReplaceLRU;
+
+/** Initializes the LRU queue */
+void ReplaceLRU_init(ReplaceLRU* r, int numberOfPhysicalPages);
+
+/** Nothing to free, the queue is made of the pages themselves */
+void ReplaceLRU_free(ReplaceLRU* r);
+
+/**
+ * Return page to tail of LRU queue
+ * @details O(1)
+ */
+static inline void ReplaceLRU_notifyPageAccess(ReplaceLRU* r, VPage* v) {
+    assert(v->inMemory);
+
+    // grab the page and stick it back on the tail of the queue
+    TAILQ_REMOVE(&r->queue, v, meta.lru.entries);
+    TAILQ_INSERT_TAIL(&r->queue, v, meta.lru.entries);
+}
+
+/**
+ * Enqueue page to LRU queue
+ * @details O(1)
+ */
+static inline void ReplaceLRU_notifyPageLoad(ReplaceLRU* r, VPage* v) {
+    assert(v->inMemory);
+    TAILQ_INSERT_TAIL(&r->queue, v, meta.lru.entries); // tail: newest
+    r->pages++;
+}
+
+/**
+ * Remove page from LRU queue
+ * @details O(1)
+ */
+static inline void ReplaceLRU_notifyPageEvict(ReplaceLRU* r, VPage* v) {
+    assert(v->inMemory && r->pages > 0);
+    TAILQ_REMOVE(&r->queue, v, meta.lru.entries);
+    r->pages--;
+}
+
+/**
+ * Oldest page in the LRU queue
+ * @details O(1)
+ * @return PPN of page to evict
+ */
+static inline unsigned long ReplaceLRU_getPageToEvict(ReplaceLRU* r) {
+    assert(r->pages > 0);
+
+    // head of queue holds oldest item
+    return TAILQ_FIRST(&r->queue)->currentPPN;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-mglru.c
+ * @brief Replacement module implementing a multi-generational LRU. Overhead
+ * is tied to virtual pages, and lives in them.
+ * @details the hooks other than eviction are inline, in replace-mglru.h
+ */
+
+#include "replace-mglru.h"
+#include <stdio.h>
+
+void ReplaceMGLRU_init(ReplaceMGLRU* r, int numberOfPhysicalPages) {
+    for (int i = 0; i < MGLRU_GENERATIONS; i++) TAILQ_INIT(&r->gens[i]);
+    r->minSeq = 0;
+    r->maxSeq = MGLRU_MIN_GENERATIONS - 1;
+    r->pages = 0;
+    r->capacity = numberOfPhysicalPages;
+    r->evictions = 0;
+    r->sweeps = 0;
+    r->agingScanned = 0;
+    r->evictScanned = 0;
+    r->promotions = 0;
+}
+
+void ReplaceMGLRU_free(ReplaceMGLRU* r) {
+    assert(r->pages >= 0 && r->pages <= r->capacity);
+    for (int i = 0; i < MGLRU_GENERATIONS; i++) TAILQ_INIT(&r->gens[i]);
+    r->pages = 0;
+}
+
+void ReplaceMGLRU_printStats(const ReplaceMGLRU* r) {
+    printf("  \x1B[96mmglru aging:\x1B[0m %lu sweeps, %.1f pages scanned "
+           "each\n",
+           r->sweeps, r->sweeps ? (double)r->agingScanned / r->sweeps : 0.0);
+    printf("  \x1B[96mmglru eviction:\x1B[0m %.2f pages scanned per "
+           "eviction, aging included, %lu promoted\n",
+           r->evictions ? (double)(r->agingScanned + r->evictScanned)
+                            / r->evictions
+                        : 0.0,
+           r->promotions);
+}
+
+/**
+ * Opens a new youngest generation and moves every accessed page into it, in
+ * the order they were in, clearing their bits
+ * @details O(pages)
+ */
+static void ReplaceMGLRU_age(ReplaceMGLRU* r) {
+    assert(r->maxSeq - r->minSeq + 1 < MGLRU_GENERATIONS);
+    r->maxSeq++;
+    unsigned char young = r->maxSeq % MGLRU_GENERATIONS;
+    assert(TAILQ_EMPTY(&r->gens[young]));
+    r->sweeps++;
+
+    for (unsigned long seq = r->minSeq; seq < r->maxSeq; seq++) {
+        struct mglru_gen_t* gen = &r->gens[seq % MGLRU_GENERATIONS];
+        VPage* v = TAILQ_FIRST(gen);
+        while (v != NULL) {
+            VPage* next = TAILQ_NEXT(v, meta.mglru.entries);
+            r->agingScanned++;
+            if (v->meta.mglru.accessed) {
+                v->meta.mglru.accessed = false;
+                TAILQ_REMOVE(gen, v, meta.mglru.entries);
+                TAILQ_INSERT_TAIL(&r->gens[young], v, meta.mglru.entries);
+                v->meta.mglru.gen = young;
+            }
+            v = next;
+        }
+    }
+}
+
+unsigned long ReplaceMGLRU_getPageToEvict(ReplaceMGLRU* r) {
+    assert(r->pages > 0);
+    r->evictions++;
+
+    for (;;) {
+        struct mglru_gen_t* oldest = &r->gens[r->minSeq % MGLRU_GENERATIONS];
+        VPage* v = TAILQ_FIRST(oldest);
+        if (v == NULL) {
+            // retire the empty generation, unless it's one of the last two
+            if (r->maxSeq - r->minSeq + 1 > MGLRU_MIN_GENERATIONS) {
+                r->minSeq++;
+            } else {
+                ReplaceMGLRU_age(r);
+            }
+            continue;
+        }
+
+        r->evictScanned++;
+        if (!v->meta.mglru.accessed) return v->currentPPN;
+
+        // referenced since it was aged: not a victim after all
+        unsigned char young = r->maxSeq % MGLRU_GENERATIONS;
+        v->meta.mglru.accessed = false;
+        TAILQ_REMOVE(oldest, v, meta.mglru.entries);
+        TAILQ_INSERT_TAIL(&r->gens[young], v, meta.mglru.entries);
+        v->meta.mglru.gen = young;
+        r->promotions++;
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-mglru.h
+ * @brief Inline hooks of a multi-generational LRU, after the one in Linux.
+ * Resident pages are split into a few generations, oldest to youngest, each
+ * a list linked through VPage.meta.mglru. A hit only sets the page's accessed
+ * bit. Pages are loaded into the youngest generation, and victims come from
+ * the oldest; a victim found accessed is promoted to the youngest instead.
+ * When only two generations are left and the oldest runs out, an aging sweep
+ * opens a new youngest generation and moves every accessed page into it,
+ * clearing the bits, so pages are reordered in batches rather than on every
+ * hit.
+ * @details Generations are numbered by sequence, from minSeq to maxSeq, and
+ * stored in a ring of MGLRU_GENERATIONS lists by sequence modulo its size.
+ * There are always at least MGLRU_MIN_GENERATIONS of them, and aging opens
+ * one only when there are that few, so the ring never wraps.
+ */
+
+#ifndef _REPLACE_MGLRU_
+#define _REPLACE_MGLRU_
+
+#include "memory.h"
+#include <assert.h>
+#include <sys/queue.h>
+
+#define MGLRU_GENERATIONS 4     // the ring, as in Linux (MAX_NR_GENS)
+#define MGLRU_MIN_GENERATIONS 2 // as in Linux (MIN_NR_GENS)
+
+// pages of a generation, in the order they entered it
+TAILQ_HEAD(mglru_gen_t, vpage_t);
+
+typedef struct replace_mglru_t {
+    struct mglru_gen_t gens[MGLRU_GENERATIONS]; // by sequence number, mod 4
+    unsigned long minSeq; // oldest generation
+    unsigned long maxSeq; // youngest generation
+    int pages;    // resident, in all generations
+    int capacity; // size of physical memory
+
+    // counters
+    unsigned long evictions;
+    unsigned long sweeps;       // aging sweeps
+    unsigned long agingScanned; // pages looked at by aging sweeps
+    unsigned long evictScanned; // pages looked at for a victim
+    unsigned long promotions;   // accessed pages moved up by eviction
+} ReplaceMGLRU;
+
+/** Initializes the generations, all empty */
+void ReplaceMGLRU_init(ReplaceMGLRU* r, int numberOfPhysicalPages);
+
+/** Nothing to free, the generations are made of the pages themselves */
+void ReplaceMGLRU_free(ReplaceMGLRU* r);
+
+/** Prints the aging sweeps and the pages scanned per eviction */
+void ReplaceMGLRU_printStats(const ReplaceMGLRU* r);
+
+/**
+ * Takes victims from the head of the oldest generation, promoting the ones
+ * accessed since they were aged, and aging when the oldest runs out
+ * @return PPN of page to evict
+ */
+unsigned long ReplaceMGLRU_getPageToEvict(ReplaceMGLRU* r);
+
+/**
+ * Set the accessed bit, for the next aging sweep or eviction to find
+ * @details O(1), a store
+ */
+static inline void ReplaceMGLRU_notifyPageAccess(
+  __attribute__((unused)) ReplaceMGLRU* r, VPage* v) {
+    assert(v->inMemory);
+    v->meta.mglru.accessed = true;
+}
+
+/**
+ * Add the page to the tail of the youngest generation
+ * @details O(1)
+ */
+static inline void ReplaceMGLRU_notifyPageLoad(ReplaceMGLRU* r, VPage* v) {
+    assert(v->inMemory && r->pages < r->capacity);
+    unsigned char gen = r->maxSeq % MGLRU_GENERATIONS;
+    TAILQ_INSERT_TAIL(&r->gens[gen], v, meta.mglru.entries);
+    v->meta.mglru.gen = gen;
+    v->meta.mglru.accessed = false;
+    r->pages++;
+}
+
+/**
+ * Remove the page from its generation
+ * @details O(1)
+ */
+static inline void ReplaceMGLRU_notifyPageEvict(ReplaceMGLRU* r, VPage* v) {
+    assert(v->inMemory && r->pages > 0);
+    TAILQ_REMOVE(&r->gens[v->meta.mglru.gen], v, meta.mglru.entries);
+    r->pages--;
+}
+
+#endif
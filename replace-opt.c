@@ -0,0 +1,58 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-opt.c
+ * @brief Replacement module implementing OPT. Overhead is tied to physical
+ * pages, as a heap of PPNs with shadow arrays of keys, heap slots and load
+ * order; the next-use index it reads lives in the processes' RefColumns.
+ * @details the per-reference hooks are inline, in replace-opt.h
+ */
+
+#include "replace-opt.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void ReplaceOPT_init(ReplaceOPT* r, int numberOfPhysicalPages) {
+    r->capacity = numberOfPhysicalPages;
+    r->heap = malloc(r->capacity * sizeof(*r->heap));
+    r->key = malloc(r->capacity * sizeof(*r->key));
+    r->slot = malloc(r->capacity * sizeof(*r->slot));
+    r->loaded = malloc(r->capacity * sizeof(*r->loaded));
+    if (r->heap == NULL || r->key == NULL || r->slot == NULL
+        || r->loaded == NULL) {
+        perror("Cannot allocate memory for OPT heap.");
+        exit(EXIT_FAILURE);
+    }
+    r->pages = 0;
+    r->incoming = REF_NEVER;
+    r->loads = 0;
+    r->references = 0;
+    r->evictions = 0;
+    r->dead = 0;
+    r->moves = 0;
+}
+
+void ReplaceOPT_free(ReplaceOPT* r) {
+    assert(r->pages >= 0 && r->pages <= r->capacity);
+    free(r->heap);
+    free(r->key);
+    free(r->slot);
+    free(r->loaded);
+    r->heap = NULL;
+    r->key = NULL;
+    r->slot = NULL;
+    r->loaded = NULL;
+    r->pages = 0;
+}
+
+void ReplaceOPT_printStats(const ReplaceOPT* r) {
+    size_t bytes = r->capacity
+                   * (sizeof(*r->heap) + sizeof(*r->key) + sizeof(*r->slot)
+                      + sizeof(*r->loaded));
+    printf("  \x1B[96mopt heap:\x1B[0m %zu KB, %.2f levels sifted per "
+           "reference\n",
+           bytes / 1024,
+           r->references ? (double)r->moves / r->references : 0.0);
+    printf("  \x1B[96mopt victims:\x1B[0m %lu of %lu never referenced "
+           "again\n",
+           r->dead, r->evictions);
+}
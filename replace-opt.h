@@ -0,0 +1,166 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-opt.h
+ * @brief Inline hooks of OPT, Belady's optimal offline policy: evict the
+ * resident page whose next reference is farthest in the future. Not
+ * realizable online, it bounds what any policy could do on a trace.
+ * @details The future comes from the next-use index built by
+ * first_pass_nextUse, which the simulator hands over with
+ * Replace_notifyNextUse on every reference. "Farthest" is by trace line,
+ * the order the trace recorded references in, which is also the order the
+ * simulation runs them in except where processes overlap around faults.
+ * Resident pages are kept in a binary max-heap keyed on their next use; its
+ * slots and keys are shadow arrays by PPN, like Clock's reference bits. A
+ * hit only ever pushes a page's next use later, so it sifts up; loads and
+ * evictions are O(log frames). Only pages never used again share a key, and
+ * the earliest loaded of them goes first, so the victim doesn't depend on
+ * which frames the pages happen to sit in.
+ */
+
+#ifndef _REPLACE_OPT_
+#define _REPLACE_OPT_
+
+#include "memory.h"
+#include "process.h"
+#include <assert.h>
+#include <stdbool.h>
+
+typedef struct replace_opt_t {
+    unsigned long* heap; // PPNs, the farthest next use at the root
+    unsigned long* key;    // by PPN, trace line of the page's next use
+    unsigned int* slot;    // by PPN, position in heap
+    unsigned long* loaded; // by PPN, load order, to break ties in key
+    int pages;             // in the heap
+    int capacity;          // size of physical memory
+
+    unsigned long incoming; // next use of the page being faulted in
+    unsigned long loads;
+
+    // counters
+    unsigned long references;
+    unsigned long evictions;
+    unsigned long dead;  // victims never referenced again
+    unsigned long moves; // heap levels sifted through
+} ReplaceOPT;
+
+/** Allocates an empty heap and its shadow arrays */
+void ReplaceOPT_init(ReplaceOPT* r, int numberOfPhysicalPages);
+
+/** Frees the heap and its shadow arrays */
+void ReplaceOPT_free(ReplaceOPT* r);
+
+/** Prints the heap's cost and how many victims were dead */
+void ReplaceOPT_printStats(const ReplaceOPT* r);
+
+/**
+ * @return true if the page in frame a goes before the one in frame b: it's
+ * used later, or it's used at the same time (never) and was loaded earlier
+ */
+static inline bool ReplaceOPT_before(const ReplaceOPT* r, unsigned long a,
+                                     unsigned long b) {
+    return r->key[a] != r->key[b] ? r->key[a] > r->key[b]
+                                  : r->loaded[a] < r->loaded[b];
+}
+
+/** Moves the entry at slot i toward the root while it goes first */
+static inline void ReplaceOPT_siftUp(ReplaceOPT* r, unsigned int i) {
+    unsigned long ppn = r->heap[i];
+    while (i > 0) {
+        unsigned int parent = (i - 1) / 2;
+        if (!ReplaceOPT_before(r, ppn, r->heap[parent])) break;
+        r->heap[i] = r->heap[parent];
+        r->slot[r->heap[i]] = i;
+        i = parent;
+        r->moves++;
+    }
+    r->heap[i] = ppn;
+    r->slot[ppn] = i;
+}
+
+/** Moves the entry at slot i toward the leaves while a child goes first */
+static inline void ReplaceOPT_siftDown(ReplaceOPT* r, unsigned int i) {
+    unsigned long ppn = r->heap[i];
+    unsigned int n = r->pages;
+    for (;;) {
+        unsigned int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n
+            && ReplaceOPT_before(r, r->heap[child + 1], r->heap[child])) {
+            child++;
+        }
+        if (!ReplaceOPT_before(r, r->heap[child], ppn)) break;
+        r->heap[i] = r->heap[child];
+        r->slot[r->heap[i]] = i;
+        i = child;
+        r->moves++;
+    }
+    r->heap[i] = ppn;
+    r->slot[ppn] = i;
+}
+
+/**
+ * The page is being referenced, and will next be at trace line line. A
+ * resident page moves up the heap; otherwise it's on its way in, and takes
+ * the line when it loads.
+ * @details O(log frames)
+ */
+static inline void ReplaceOPT_notifyNextUse(ReplaceOPT* r, VPage* v,
+                                            unsigned long line) {
+    r->references++;
+    if (!v->inMemory) {
+        r->incoming = line;
+        return;
+    }
+    assert(line >= r->key[v->currentPPN] && "next use went back in time");
+    r->key[v->currentPPN] = line;
+    ReplaceOPT_siftUp(r, r->slot[v->currentPPN]);
+}
+
+/**
+ * Nothing to do, the next use came with Replace_notifyNextUse
+ * @details O(1)
+ */
+static inline void ReplaceOPT_notifyPageAccess(
+  __attribute__((unused)) ReplaceOPT* r, __attribute__((unused)) VPage* v) {}
+
+/**
+ * Add the page to the heap, keyed on its next use
+ * @details O(log frames)
+ */
+static inline void ReplaceOPT_notifyPageLoad(ReplaceOPT* r, VPage* v) {
+    assert(v->inMemory && r->pages < r->capacity);
+    r->key[v->currentPPN] = r->incoming;
+    r->loaded[v->currentPPN] = r->loads++;
+    r->heap[r->pages] = v->currentPPN;
+    ReplaceOPT_siftUp(r, r->pages++);
+}
+
+/**
+ * Remove the page from the heap, filling its slot with the last entry
+ * @details O(log frames)
+ */
+static inline void ReplaceOPT_notifyPageEvict(ReplaceOPT* r, VPage* v) {
+    assert(v->inMemory && r->pages > 0);
+    unsigned int i = r->slot[v->currentPPN];
+    assert(r->heap[i] == v->currentPPN);
+    unsigned long last = r->heap[--r->pages];
+    if (i == (unsigned int)r->pages) return; // it was the last entry
+    r->heap[i] = last;
+    r->slot[last] = i;
+    ReplaceOPT_siftUp(r, i);
+    ReplaceOPT_siftDown(r, r->slot[last]);
+}
+
+/**
+ * The page whose next use is farthest away, at the root of the heap
+ * @details O(1)
+ * @return PPN of page to evict
+ */
+static inline unsigned long ReplaceOPT_getPageToEvict(ReplaceOPT* r) {
+    assert(r->pages > 0);
+    r->evictions++;
+    if (r->key[r->heap[0]] == REF_NEVER) r->dead++;
+    return r->heap[0];
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-pff.c
+ * @brief Replacement module implementing PFF. Overhead is tied to physical
+ * pages, in a shadow array of frames on memory, plus each process's
+ * allowance in its ResidentSet.
+ * @details the hooks other than eviction are inline, in replace-pff.h
+ */
+
+#include "replace-pff.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void ReplacePFF_init(ReplacePFF* r, int numberOfPhysicalPages,
+                     unsigned long threshold) {
+    r->pages = numberOfPhysicalPages;
+    r->frames = calloc(r->pages, sizeof(PffFrame));
+    if (r->frames == NULL) {
+        perror("Cannot allocate memory for PFF frames.");
+        exit(EXIT_FAILURE);
+    }
+    r->hand = 0;
+    r->over = 0;
+    r->threshold = threshold != 0 ? threshold : PFF_THRESHOLD;
+    r->faulting = NULL;
+    r->evictions = 0;
+    r->travel = 0;
+    r->local = 0;
+    r->grows = 0;
+    r->shrinks = 0;
+}
+
+void ReplacePFF_free(ReplacePFF* r) {
+    free(r->frames);
+    r->frames = NULL;
+}
+
+void ReplacePFF_printStats(const ReplacePFF* r) {
+    printf("  \x1B[96mpff allowances:\x1B[0m T %lu references, %lu grown, "
+           "%lu shrunk\n",
+           r->threshold, r->grows, r->shrinks);
+    printf("  \x1B[96mpff victims:\x1B[0m %lu of %lu from the faulting "
+           "process, %.2f frames of hand travel each\n",
+           r->local, r->evictions,
+           r->evictions ? (double)r->travel / r->evictions : 0.0);
+}
+
+/**
+ * @return true if the page in a frame may be evicted for a fault of a
+ * process
+ * @param local the faulting process is at its allowance, so it replaces its
+ * own pages
+ */
+static inline bool ReplacePFF_eligible(const PffFrame* f,
+                                       const ResidentSet* faulting,
+                                       bool local) {
+    const ResidentSet* owner = f->page->owner;
+    return local ? owner == faulting
+                 : owner->pages > owner->meta.pff.allowance;
+}
+
+unsigned long ReplacePFF_getPageToEvict(ReplacePFF* r) {
+    assert(r->faulting != NULL);
+    r->evictions++;
+    bool local = r->faulting->pages > 0
+                 && r->faulting->pages >= r->faulting->meta.pff.allowance;
+
+    // two sweeps over the frames that may go, the first of which may only
+    // clear bits; if none may, because no process can lose a frame, any can,
+    // and after PFF_SCAN frames the one at the hand goes even if referenced
+    for (int any = !local && r->over == 0; any <= 1; any++) {
+        for (int moved = 0; moved < 2 * r->pages; moved++) {
+            unsigned long ppn = r->hand;
+            PffFrame* f = &r->frames[ppn];
+            assert(f->page != NULL && "memory should be full");
+            r->hand = (r->hand + 1) % r->pages;
+            r->travel++;
+
+            if (!any && !ReplacePFF_eligible(f, r->faulting, local)) continue;
+            if (f->referenced && !(any && moved >= PFF_SCAN)) {
+                f->referenced = false;
+                continue;
+            }
+            if (!any && local) r->local++;
+            return ppn;
+        }
+        assert(any && "a process over its allowance has frames to lose");
+    }
+    assert(false && "two sweeps always find an unreferenced page");
+    return r->hand;
+}
@@ -0,0 +1,162 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-pff.h
+ * @brief Inline hooks of PFF, the Page Fault Frequency policy (Chu and
+ * Opderbeck, 1972). Each process has an allowance of frames, set from the
+ * time between its faults, in its own virtual time (see ResidentSet): a
+ * fault less than a threshold T after the last one grows the allowance by a
+ * frame, and a later one shrinks it to the pages the process referenced
+ * since its last such shrink. A process at its allowance that faults
+ * replaces one of its own pages; otherwise the victim comes from a process
+ * over its allowance, so one process's scan can't take the frames of
+ * another that is faulting rarely.
+ * @details Victims are picked with a clock hand over a shadow array of
+ * frames by PPN, skipping frames of processes that can't lose one, and
+ * giving referenced pages a second chance as in Clock. The pages referenced
+ * since a shrink are counted as they happen, by comparing each frame's
+ * last-use time with the owner's last shrink, so a fault never scans a
+ * process's pages. T defaults to PFF_THRESHOLD, short enough that both
+ * rules get used even on traces that fault every few references. If no
+ * process is over its allowance, which PFF keeps count of, any page can go,
+ * as in Clock, but after PFF_SCAN frames the one at the hand goes whether
+ * it was referenced or not, so a fault never has to walk all of memory.
+ */
+
+#ifndef _REPLACE_PFF_
+#define _REPLACE_PFF_
+
+#include "memory.h"
+#include <assert.h>
+#include <stdbool.h>
+
+#define PFF_THRESHOLD 16 // default T, in references
+#define PFF_SCAN 64       // frames looked at before any page at all will do
+
+typedef struct pff_frame_t {
+    VPage* page;
+    ul64 lastUse; // owner's virtual time at the last reference
+    bool referenced;
+} PffFrame;
+
+typedef struct replace_pff_t {
+    PffFrame* frames; // by PPN
+    unsigned long hand;
+    int pages;      // size of memory in pages
+    int over;       // processes over their allowance
+    ul64 threshold; // T, in references of the faulting process
+
+    ResidentSet* faulting; // owner of the page being faulted in
+
+    // counters
+    unsigned long evictions;
+    unsigned long travel; // frames the hand moved past
+    unsigned long local;  // victims from the faulting process itself
+    unsigned long grows;
+    unsigned long shrinks;
+} ReplacePFF;
+
+/**
+ * Creates the frame array, with the hand at PPN 0
+ * @param threshold fault interval threshold T, in references of the
+ * faulting process, or 0 for the default, PFF_THRESHOLD
+ */
+void ReplacePFF_init(ReplacePFF* r, int numberOfPhysicalPages,
+                     unsigned long threshold);
+
+/** Frees the frame array */
+void ReplacePFF_free(ReplacePFF* r);
+
+/** Prints allowance changes and where victims came from */
+void ReplacePFF_printStats(const ReplacePFF* r);
+
+/**
+ * Recounts whether a process is over its allowance
+ * @param pages the process's resident pages, or what they're about to be
+ */
+static inline void ReplacePFF_recount(ReplacePFF* r, ResidentSet* s,
+                                      ul64 pages) {
+    bool over = pages > s->meta.pff.allowance;
+    r->over += (int)over - (int)s->meta.pff.over;
+    s->meta.pff.over = over;
+}
+
+/**
+ * Sweeps from the hand for an unreferenced page of a process that can lose
+ * a frame
+ * @return PPN of page to evict
+ */
+unsigned long ReplacePFF_getPageToEvict(ReplacePFF* r);
+
+/**
+ * Turn the reference bit on, counting the page as used since the owner's
+ * last shrink if it wasn't yet
+ * @details O(1)
+ */
+static inline void ReplacePFF_notifyPageAccess(ReplacePFF* r, VPage* v) {
+    assert(v->inMemory && v->owner != NULL);
+    PffFrame* f = &r->frames[v->currentPPN];
+    ResidentSet* owner = v->owner;
+    if (f->lastUse < owner->meta.pff.lastShrink) owner->meta.pff.used++;
+    f->lastUse = owner->virtualTime;
+    f->referenced = true;
+}
+
+/**
+ * Measures the interval since the owner's last fault, and grows or shrinks
+ * its allowance
+ * @details O(1)
+ */
+static inline void ReplacePFF_notifyPageFault(ReplacePFF* r, VPage* v) {
+    assert(v->owner != NULL);
+    ResidentSet* owner = v->owner;
+    ul64 now = owner->virtualTime;
+    if (now - owner->meta.pff.lastFault < r->threshold) {
+        if (owner->meta.pff.allowance < (ul64)r->pages) {
+            owner->meta.pff.allowance++;
+        }
+        r->grows++;
+    } else {
+        // pages not referenced since the last shrink drop out, and this one
+        // comes in
+        owner->meta.pff.allowance = owner->meta.pff.used + 1;
+        owner->meta.pff.used = 0;
+        owner->meta.pff.lastShrink = now;
+        r->shrinks++;
+    }
+    ReplacePFF_recount(r, owner, owner->pages);
+    owner->meta.pff.lastFault = now;
+    r->faulting = owner;
+}
+
+/**
+ * A newly loaded page starts out referenced, and used now
+ * @details O(1)
+ */
+static inline void ReplacePFF_notifyPageLoad(ReplacePFF* r, VPage* v) {
+    assert(v->inMemory && v->owner != NULL);
+    PffFrame* f = &r->frames[v->currentPPN];
+    f->page = v;
+    f->lastUse = v->owner->virtualTime;
+    f->referenced = true;
+    v->owner->meta.pff.used++;
+    ReplacePFF_recount(r, v->owner, v->owner->pages);
+}
+
+/**
+ * Empty the frame, and stop counting the page as used
+ * @details O(1)
+ */
+static inline void ReplacePFF_notifyPageEvict(ReplacePFF* r, VPage* v) {
+    assert(v->inMemory && v->owner != NULL);
+    PffFrame* f = &r->frames[v->currentPPN];
+    if (f->lastUse >= v->owner->meta.pff.lastShrink) {
+        assert(v->owner->meta.pff.used > 0);
+        v->owner->meta.pff.used--;
+    }
+    f->page = NULL;
+    f->referenced = false;
+    // the page isn't uncounted from the owner yet
+    ReplacePFF_recount(r, v->owner, v->owner->pages - 1);
+}
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-random.h
+ * @brief Inline hooks of the random replacement policy, which keeps no state
+ * per page.
+ * @author Michael Noguera
+ */
+
+#ifndef _REPLACE_RANDOM_
+#define _REPLACE_RANDOM_
+
+#include "memory.h"
+#include "rng.h"
+
+typedef struct replace_random_t {
+    int pages; // size of memory in pages
+    // generator state, private to this instance so that simulations running
+    // side by side don't perturb each other's sequence
+    Rng rng;
+} ReplaceRandom;
+
+/** Seeds the generator with the seed from --seed */
+void ReplaceRandom_init(ReplaceRandom* r, int numberOfPhysicalPages,
+                        uint64_t seed);
+
+void ReplaceRandom_free(ReplaceRandom* r);
+
+static inline void ReplaceRandom_notifyPageAccess(
+  __attribute__((unused)) ReplaceRandom* r, __attribute__((unused)) VPage* v) {}
+static inline void ReplaceRandom_notifyPageLoad(
+  __attribute__((unused)) ReplaceRandom* r, __attribute__((unused)) VPage* v) {}
+static inline void ReplaceRandom_notifyPageEvict(
+  __attribute__((unused)) ReplaceRandom* r, __attribute__((unused)) VPage* v) {}
+
+/**
+ * Randomly chooses a page to evict.
+ * @details See rng.h for the generator. Runs with the same seed evict the
+ * same pages.
+ * @return index of page, within the interval [0, numberOfPages)
+ */
+static inline unsigned long ReplaceRandom_getPageToEvict(ReplaceRandom* r) {
+    return Rng_below(&r->rng, r->pages);
+}
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-s3fifo.c
+ * @brief Replacement module implementing S3-FIFO. Overhead is tied to
+ * virtual pages, and lives in them, plus the ghost fingerprint table, tied
+ * to physical pages.
+ * @details the per-reference hooks are inline, in replace-s3fifo.h
+ */
+
+#include "replace-s3fifo.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void ReplaceS3FIFO_init(ReplaceS3FIFO* r, int numberOfPhysicalPages) {
+    TAILQ_INIT(&r->small);
+    TAILQ_INIT(&r->main);
+    r->smallPages = 0;
+    r->mainPages = 0;
+    r->capacity = numberOfPhysicalPages;
+    r->smallTarget = r->capacity / 10 > 0 ? r->capacity / 10 : 1;
+
+    size_t slots = S3FIFO_PROBES;
+    while (slots < 2 * (size_t)r->capacity) slots *= 2;
+    r->ghosts = calloc(slots, sizeof(S3fifoGhostSlot));
+    if (r->ghosts == NULL) {
+        perror("Cannot allocate memory for S3-FIFO ghosts.");
+        exit(EXIT_FAILURE);
+    }
+    r->ghostMask = slots - 1;
+    r->ghostCount = 0;
+    r->ghostLength = r->capacity;
+    r->victim = -1;
+
+    r->evictions = 0;
+    r->smallEvictions = 0;
+    r->promotions = 0;
+    r->reinsertions = 0;
+    r->ghostHits = 0;
+}
+
+void ReplaceS3FIFO_free(ReplaceS3FIFO* r) {
+    assert(r->smallPages + r->mainPages <= r->capacity);
+    free(r->ghosts);
+    r->ghosts = NULL;
+    TAILQ_INIT(&r->small);
+    TAILQ_INIT(&r->main);
+    r->smallPages = 0;
+    r->mainPages = 0;
+}
+
+void ReplaceS3FIFO_printStats(const ReplaceS3FIFO* r) {
+    printf("  \x1B[96ms3fifo victims:\x1B[0m %lu of %lu from the small "
+           "queue\n",
+           r->smallEvictions, r->evictions);
+    printf("  \x1B[96ms3fifo moves:\x1B[0m %lu promoted to main, %lu "
+           "reinserted in main, %lu ghost hits\n",
+           r->promotions, r->reinsertions, r->ghostHits);
+}
+
+/** @return a hash of a key, fingerprint in the high half, slot in the low */
+static inline uint64_t ReplaceS3FIFO_hash(ul64 pid, ul64 vpn) {
+    uint64_t h = (pid * 0xD6E8FEB86659FD93ULL) ^ vpn;
+    // MurmurHash3's 64-bit finalizer
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/** @return the nonzero fingerprint of a hash */
+static inline uint32_t ReplaceS3FIFO_fingerprint(uint64_t h) {
+    uint32_t fingerprint = h >> 32;
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+/** @return true if a slot holds a ghost still on the queue */
+static inline bool ReplaceS3FIFO_live(const ReplaceS3FIFO* r,
+                                      const S3fifoGhostSlot* s) {
+    return s->fingerprint != 0
+           && (uint32_t)(r->ghostCount - s->insertedAt) < r->ghostLength;
+}
+
+void ReplaceS3FIFO_remember(ReplaceS3FIFO* r, ul64 pid, ul64 vpn) {
+    uint64_t h = ReplaceS3FIFO_hash(pid, vpn);
+    uint32_t fingerprint = ReplaceS3FIFO_fingerprint(h);
+
+    // the first free or expired slot in the window, or else its oldest
+    S3fifoGhostSlot* target = NULL;
+    for (int i = 0; i < S3FIFO_PROBES; i++) {
+        S3fifoGhostSlot* s = &r->ghosts[(h + i) & r->ghostMask];
+        if (!ReplaceS3FIFO_live(r, s) || s->fingerprint == fingerprint) {
+            target = s;
+            break;
+        }
+        if (target == NULL
+            || (uint32_t)(r->ghostCount - s->insertedAt)
+                 > (uint32_t)(r->ghostCount - target->insertedAt)) {
+            target = s;
+        }
+    }
+    target->fingerprint = fingerprint;
+    target->insertedAt = r->ghostCount++;
+}
+
+bool ReplaceS3FIFO_recall(ReplaceS3FIFO* r, ul64 pid, ul64 vpn) {
+    uint64_t h = ReplaceS3FIFO_hash(pid, vpn);
+    uint32_t fingerprint = ReplaceS3FIFO_fingerprint(h);
+    for (int i = 0; i < S3FIFO_PROBES; i++) {
+        S3fifoGhostSlot* s = &r->ghosts[(h + i) & r->ghostMask];
+        if (s->fingerprint == fingerprint && ReplaceS3FIFO_live(r, s)) {
+            s->fingerprint = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned long ReplaceS3FIFO_getPageToEvict(ReplaceS3FIFO* r) {
+    assert(r->smallPages + r->mainPages > 0);
+    r->evictions++;
+
+    // each pass moves a page or returns, and frequencies only go down, so
+    // this ends within a few passes over memory
+    for (;;) {
+        if (r->smallPages > 0
+            && (r->smallPages >= r->smallTarget || r->mainPages == 0)) {
+            VPage* v = TAILQ_FIRST(&r->small);
+            if (v->meta.s3fifo.freq == 0) {
+                r->smallEvictions++;
+                r->victim = v->currentPPN;
+                return v->currentPPN;
+            }
+            // hit while on probation: on to main
+            TAILQ_REMOVE(&r->small, v, meta.s3fifo.entries);
+            r->smallPages--;
+            TAILQ_INSERT_TAIL(&r->main, v, meta.s3fifo.entries);
+            r->mainPages++;
+            v->meta.s3fifo.main = true;
+            v->meta.s3fifo.freq = 0;
+            r->promotions++;
+        } else {
+            VPage* v = TAILQ_FIRST(&r->main);
+            if (v->meta.s3fifo.freq == 0) {
+                r->victim = v->currentPPN;
+                return v->currentPPN;
+            }
+            // lazy promotion: back on the tail, one hit spent
+            TAILQ_REMOVE(&r->main, v, meta.s3fifo.entries);
+            TAILQ_INSERT_TAIL(&r->main, v, meta.s3fifo.entries);
+            v->meta.s3fifo.freq--;
+            r->reinsertions++;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-s3fifo.h
+ * @brief Inline hooks of S3-FIFO (Yang et al., SOSP '23). Resident pages are
+ * on one of two FIFO queues, the same TAILQ as FIFO's, linked through
+ * VPage.meta.s3fifo: a small probationary one, about a tenth of memory, and
+ * a main one. A hit only bumps the page's 2-bit frequency. Faulted pages
+ * join the small queue, unless they were evicted from it recently, which a
+ * ghost queue of their keys remembers; those go straight to main. Pages
+ * leaving the small queue move to main if they were hit there, and are
+ * evicted otherwise, so pages referenced once are gone after a short stay.
+ * The main queue reinserts a page that was hit, with one less in its
+ * frequency, and evicts the first one that wasn't.
+ * @details The ghost queue holds 32-bit fingerprints of <pid, vpn>, as many
+ * as there are frames, in an open-addressed table stamped with the ghost
+ * insertion count; a stamp more than a frame count old has fallen off the
+ * queue. So it costs 8 bytes per slot, two slots per frame, and never
+ * allocates after init. A fingerprint collision can admit a page to main
+ * early, about once in 2^32 lookups.
+ */
+
+#ifndef _REPLACE_S3FIFO_
+#define _REPLACE_S3FIFO_
+
+#include "memory.h"
+#include "replace-fifo.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+#define S3FIFO_MAX_FREQ 3 // 2 bits
+#define S3FIFO_PROBES 8   // ghost slots looked at per key
+
+typedef struct s3fifo_ghost_slot_t {
+    uint32_t fingerprint; // 0 if empty
+    uint32_t insertedAt;  // ghost insertions before this one, mod 2^32
+} S3fifoGhostSlot;
+
+typedef struct replace_s3fifo_t {
+    struct fifo_queue_t small; // probation, oldest on the head
+    struct fifo_queue_t main;  // oldest on the head
+    int smallPages;
+    int mainPages;
+    int smallTarget; // the small queue's share of memory
+    int capacity;    // size of physical memory
+
+    S3fifoGhostSlot* ghosts;
+    size_t ghostMask;     // slots - 1, slots a power of two
+    uint32_t ghostCount;  // insertions so far, mod 2^32
+    uint32_t ghostLength; // ghosts kept, the number of frames
+    long victim; // PPN picked by ReplaceS3FIFO_getPageToEvict, or -1
+
+    // counters
+    unsigned long evictions;
+    unsigned long smallEvictions; // victims that never left the small queue
+    unsigned long promotions;     // from small to main
+    unsigned long reinsertions;   // within main
+    unsigned long ghostHits;      // faults admitted straight to main
+} ReplaceS3FIFO;
+
+/** Initializes both queues, and an empty ghost table */
+void ReplaceS3FIFO_init(ReplaceS3FIFO* r, int numberOfPhysicalPages);
+
+/** Frees the ghost table; the queues are made of the pages themselves */
+void ReplaceS3FIFO_free(ReplaceS3FIFO* r);
+
+/** Prints where victims came from, the queue moves and ghost hits */
+void ReplaceS3FIFO_printStats(const ReplaceS3FIFO* r);
+
+/**
+ * Evicts from the small queue while it is over its share, else from main,
+ * moving pages that were hit along the way
+ * @return PPN of page to evict
+ */
+unsigned long ReplaceS3FIFO_getPageToEvict(ReplaceS3FIFO* r);
+
+/**
+ * Remembers a page evicted from the small queue in the ghost queue
+ * @details O(1)
+ */
+void ReplaceS3FIFO_remember(ReplaceS3FIFO* r, ul64 pid, ul64 vpn);
+
+/**
+ * Forgets a page, if it is in the ghost queue
+ * @details O(1)
+ * @return true if it was
+ */
+bool ReplaceS3FIFO_recall(ReplaceS3FIFO* r, ul64 pid, ul64 vpn);
+
+/**
+ * Bump the page's frequency, up to S3FIFO_MAX_FREQ
+ * @details O(1), no list is touched
+ */
+static inline void ReplaceS3FIFO_notifyPageAccess(
+  __attribute__((unused)) ReplaceS3FIFO* r, VPage* v) {
+    assert(v->inMemory);
+    if (v->meta.s3fifo.freq < S3FIFO_MAX_FREQ) v->meta.s3fifo.freq++;
+}
+
+/**
+ * Enqueue the page on main if it is a ghost, else on the small queue
+ * @details O(1)
+ */
+static inline void ReplaceS3FIFO_notifyPageLoad(ReplaceS3FIFO* r, VPage* v) {
+    assert(v->inMemory && r->smallPages + r->mainPages < r->capacity);
+    v->meta.s3fifo.freq = 0;
+    v->meta.s3fifo.main = ReplaceS3FIFO_recall(r, v->pid, v->vpn);
+    if (v->meta.s3fifo.main) {
+        TAILQ_INSERT_TAIL(&r->main, v, meta.s3fifo.entries);
+        r->mainPages++;
+        r->ghostHits++;
+    } else {
+        TAILQ_INSERT_TAIL(&r->small, v, meta.s3fifo.entries);
+        r->smallPages++;
+    }
+}
+
+/**
+ * Remove the page from its queue; a victim leaving the small queue becomes a
+ * ghost, but a page freed because its process finished doesn't
+ * @details O(1)
+ */
+static inline void ReplaceS3FIFO_notifyPageEvict(ReplaceS3FIFO* r, VPage* v) {
+    assert(v->inMemory);
+    bool chosen = (long)v->currentPPN == r->victim;
+    r->victim = -1;
+    if (v->meta.s3fifo.main) {
+        assert(r->mainPages > 0);
+        TAILQ_REMOVE(&r->main, v, meta.s3fifo.entries);
+        r->mainPages--;
+    } else {
+        assert(r->smallPages > 0);
+        TAILQ_REMOVE(&r->small, v, meta.s3fifo.entries);
+        r->smallPages--;
+        if (chosen) ReplaceS3FIFO_remember(r, v->pid, v->vpn);
+    }
+}
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-sampled.c
+ * @brief Replacement module implementing sampled LRU. Overhead is tied to
+ * physical pages, in a shadow array of stamps on memory.
+ * @details the hooks are inline, in replace-sampled.h
+ */
+
+#include "replace-sampled.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void ReplaceSampled_init(ReplaceSampled* r, int numberOfPhysicalPages,
+                         unsigned long samples, uint64_t seed) {
+    r->pages = numberOfPhysicalPages;
+    r->stamps = calloc(r->pages, sizeof(ul64));
+    if (r->stamps == NULL) {
+        perror("Cannot allocate memory for sampled LRU stamps.");
+        exit(EXIT_FAILURE);
+    }
+    r->now = 0;
+    r->samples = samples != 0 ? (int)samples : 5;
+    Rng_init(&r->rng, seed);
+    r->evictions = 0;
+    r->victimAge = 0;
+}
+
+void ReplaceSampled_free(ReplaceSampled* r) {
+    free(r->stamps);
+    r->stamps = NULL;
+}
+
+void ReplaceSampled_printStats(const ReplaceSampled* r) {
+    printf("  \x1B[96msampled lru:\x1B[0m %i frames drawn per eviction, "
+           "victims unused for %.1f references on average\n",
+           r->samples,
+           r->evictions ? (double)r->victimAge / r->evictions : 0.0);
+}
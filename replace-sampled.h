@@ -0,0 +1,86 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-sampled.h
+ * @brief Inline hooks of sampled LRU, the approximation Redis uses: each
+ * frame holds the time of its page's last reference, and an eviction draws
+ * K frames at random and evicts the least recently used of those. A hit is
+ * one store, with no list to relink, and the victim is among the oldest
+ * 1 / (K + 1) of memory on average, so faults come close to LRU's.
+ * @details Stamps are a shadow array by PPN, like Clock's bits, counting
+ * references to this memory. Frames are drawn with replacement, from the
+ * instance's own generator (see rng.h).
+ */
+
+#ifndef _REPLACE_SAMPLED_
+#define _REPLACE_SAMPLED_
+
+#include "memory.h"
+#include "rng.h"
+#include <assert.h>
+
+typedef struct replace_sampled_t {
+    ul64* stamps; // by PPN, time of the last reference
+    ul64 now;     // references so far
+    int pages;    // size of memory in pages
+    int samples;  // K, frames drawn per eviction
+    Rng rng;
+
+    // counters
+    unsigned long evictions;
+    ul64 victimAge; // references since the victims' last ones, summed
+} ReplaceSampled;
+
+/**
+ * Creates the stamp array, and seeds the generator
+ * @param samples K, or 0 for the default of 5, as in Redis
+ */
+void ReplaceSampled_init(ReplaceSampled* r, int numberOfPhysicalPages,
+                         unsigned long samples, uint64_t seed);
+
+/** Frees the stamp array */
+void ReplaceSampled_free(ReplaceSampled* r);
+
+/** Prints the sample size and the victims' mean age */
+void ReplaceSampled_printStats(const ReplaceSampled* r);
+
+/**
+ * Stamp the page's frame with the current time
+ * @details O(1)
+ */
+static inline void ReplaceSampled_notifyPageAccess(ReplaceSampled* r,
+                                                   VPage* v) {
+    assert(v->inMemory);
+    r->stamps[v->currentPPN] = ++r->now;
+}
+
+/**
+ * A newly loaded page counts as referenced now
+ * @details O(1)
+ */
+static inline void ReplaceSampled_notifyPageLoad(ReplaceSampled* r,
+                                                 VPage* v) {
+    assert(v->inMemory);
+    r->stamps[v->currentPPN] = ++r->now;
+}
+
+static inline void ReplaceSampled_notifyPageEvict(
+  __attribute__((unused)) ReplaceSampled* r,
+  __attribute__((unused)) VPage* v) {}
+
+/**
+ * Draws K frames and picks the one referenced longest ago
+ * @details O(K)
+ * @return PPN of page to evict
+ */
+static inline unsigned long ReplaceSampled_getPageToEvict(ReplaceSampled* r) {
+    unsigned long victim = Rng_below(&r->rng, r->pages);
+    for (int i = 1; i < r->samples; i++) {
+        unsigned long ppn = Rng_below(&r->rng, r->pages);
+        if (r->stamps[ppn] < r->stamps[victim]) victim = ppn;
+    }
+    r->evictions++;
+    r->victimAge += r->now - r->stamps[victim];
+    return victim;
+}
+
+#endif
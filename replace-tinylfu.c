@@ -0,0 +1,179 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-tinylfu.c
+ * @brief Replacement module implementing W-TinyLFU. Overhead is tied to
+ * physical pages: the sketch and the shadow arrays on memory, plus the queue
+ * links in the pages themselves.
+ * @details the per-reference hooks are inline, in replace-tinylfu.h
+ */
+
+#include "replace-tinylfu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const mainNames[] = {
+  [TINYLFU_SLRU] = "slru",
+  [TINYLFU_LRU] = "lru",
+  [TINYLFU_CLOCK] = "clock",
+  [TINYLFU_FIFO] = "fifo",
+};
+
+bool ReplaceTinyLFU_parseMain(const char* name, TinyLfuMain* main) {
+    for (int i = TINYLFU_LRU; i <= TINYLFU_FIFO; i++) {
+        if (strcmp(name, mainNames[i]) == 0) {
+            *main = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplaceTinyLFU_init(ReplaceTinyLFU* r, int numberOfPhysicalPages,
+                         TinyLfuMain main) {
+    r->pages = numberOfPhysicalPages;
+
+    // 16 counters per frame, 128 to a block
+    size_t blocks = 1;
+    while (blocks * 8 < (size_t)r->pages) blocks *= 2;
+    r->sketch = aligned_alloc(sizeof(TinyLfuBlock),
+                              blocks * sizeof(TinyLfuBlock));
+    r->areas = malloc(r->pages * sizeof(unsigned char));
+    r->frames = calloc(r->pages, sizeof(VPage*));
+    if (r->sketch == NULL || r->areas == NULL || r->frames == NULL) {
+        perror("Cannot allocate memory for TinyLFU.");
+        exit(EXIT_FAILURE);
+    }
+    memset(r->sketch, 0, blocks * sizeof(TinyLfuBlock));
+    r->blockMask = blocks - 1;
+    r->additions = 0;
+    r->sampleSize = 10 * (unsigned long)r->pages;
+
+    TAILQ_INIT(&r->window);
+    r->windowPages = 0;
+    r->windowTarget = r->pages / 100 > 0 ? r->pages / 100 : 1;
+
+    r->main = main;
+    r->mainPages = 0;
+    TAILQ_INIT(&r->probation);
+    TAILQ_INIT(&r->protected);
+    r->protectedPages = 0;
+    r->protectedTarget = (r->pages - r->windowTarget) * 8 / 10;
+    switch (r->main) {
+    case TINYLFU_LRU: ReplaceLRU_init(&r->wrapped.lru, r->pages); break;
+    case TINYLFU_CLOCK: ReplaceClock_init(&r->wrapped.clock, r->pages); break;
+    case TINYLFU_FIFO: ReplaceFIFO_init(&r->wrapped.fifo, r->pages); break;
+    default: break;
+    }
+
+    r->evictions = 0;
+    r->candidates = 0;
+    r->admitted = 0;
+    r->halvings = 0;
+}
+
+void ReplaceTinyLFU_free(ReplaceTinyLFU* r) {
+    switch (r->main) {
+    case TINYLFU_LRU: ReplaceLRU_free(&r->wrapped.lru); break;
+    case TINYLFU_CLOCK: ReplaceClock_free(&r->wrapped.clock); break;
+    case TINYLFU_FIFO: ReplaceFIFO_free(&r->wrapped.fifo); break;
+    default: break;
+    }
+    free(r->sketch);
+    free(r->areas);
+    free(r->frames);
+    r->sketch = NULL;
+    r->areas = NULL;
+    r->frames = NULL;
+}
+
+void ReplaceTinyLFU_printStats(const ReplaceTinyLFU* r) {
+    printf("  \x1B[96mtinylfu admission:\x1B[0m %lu of %lu window pages "
+           "admitted to %s, window of %i\n",
+           r->admitted, r->candidates, mainNames[r->main], r->windowTarget);
+    printf("  \x1B[96mtinylfu sketch:\x1B[0m %zu bytes, halved %lu times\n",
+           (r->blockMask + 1) * sizeof(TinyLfuBlock), r->halvings);
+    if (r->main == TINYLFU_CLOCK) ReplaceClock_printStats(&r->wrapped.clock);
+}
+
+void ReplaceTinyLFU_halve(ReplaceTinyLFU* r) {
+    for (size_t b = 0; b <= r->blockMask; b++) {
+        for (int w = 0; w < 8; w++) {
+            // shifting a nibble's low bit into its neighbour, then masking it
+            // out, halves all 16 at once
+            r->sketch[b].words[w] =
+              (r->sketch[b].words[w] >> 1) & 0x7777777777777777ULL;
+        }
+    }
+    r->additions /= 2;
+    r->halvings++;
+}
+
+/**
+ * @return the main area's victim, which stays put until it is evicted
+ */
+static unsigned long ReplaceTinyLFU_mainVictim(ReplaceTinyLFU* r) {
+    assert(r->mainPages > 0);
+    switch (r->main) {
+    case TINYLFU_SLRU: {
+        VPage* v = TAILQ_FIRST(&r->probation);
+        if (v == NULL) v = TAILQ_FIRST(&r->protected);
+        return v->currentPPN;
+    }
+    case TINYLFU_LRU: return ReplaceLRU_getPageToEvict(&r->wrapped.lru);
+    case TINYLFU_FIFO: return ReplaceFIFO_getPageToEvict(&r->wrapped.fifo);
+    case TINYLFU_CLOCK:
+        // Clock sweeps every frame; window pages get their bit set again,
+        // so the hand passes them by, in one eviction as Clock counts them
+        for (;;) {
+            unsigned long ppn = ReplaceClock_getPageToEvict(&r->wrapped.clock);
+            if (r->areas[ppn] == TINYLFU_WRAPPED) return ppn;
+            ReplaceClock_notifyPageAccess(&r->wrapped.clock, r->frames[ppn]);
+            r->wrapped.clock.evictions--;
+        }
+    default: assert(false); return 0;
+    }
+}
+
+void ReplaceTinyLFU_admit(ReplaceTinyLFU* r, VPage* v) {
+    TAILQ_REMOVE(&r->window, v, meta.tinylfu.entries);
+    r->windowPages--;
+    r->mainPages++;
+    switch (r->main) {
+    case TINYLFU_SLRU:
+        TAILQ_INSERT_TAIL(&r->probation, v, meta.tinylfu.entries);
+        r->areas[v->currentPPN] = TINYLFU_PROBATION;
+        return;
+    case TINYLFU_LRU: ReplaceLRU_notifyPageLoad(&r->wrapped.lru, v); break;
+    case TINYLFU_CLOCK:
+        ReplaceClock_notifyPageLoad(&r->wrapped.clock, v);
+        break;
+    case TINYLFU_FIFO: ReplaceFIFO_notifyPageLoad(&r->wrapped.fifo, v); break;
+    default: assert(false);
+    }
+    r->areas[v->currentPPN] = TINYLFU_WRAPPED;
+}
+
+unsigned long ReplaceTinyLFU_getPageToEvict(ReplaceTinyLFU* r) {
+    assert(r->windowPages + r->mainPages == r->pages);
+    r->evictions++;
+
+    // the faulting page will join the window; while it has room, the main
+    // area gives up a page
+    VPage* candidate = TAILQ_FIRST(&r->window);
+    if (candidate == NULL
+        || (r->windowPages < r->windowTarget && r->mainPages > 0)) {
+        return ReplaceTinyLFU_mainVictim(r);
+    }
+    if (r->mainPages == 0) return candidate->currentPPN;
+
+    r->candidates++;
+    unsigned long victim = ReplaceTinyLFU_mainVictim(r);
+    if (ReplaceTinyLFU_frequency(r, candidate)
+        <= ReplaceTinyLFU_frequency(r, r->frames[victim])) {
+        return candidate->currentPPN;
+    }
+    ReplaceTinyLFU_admit(r, candidate);
+    r->admitted++;
+    return victim;
+}
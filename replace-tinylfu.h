@@ -0,0 +1,294 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-tinylfu.h
+ * @brief Inline hooks of W-TinyLFU (Einziger et al., TOS '17), an admission
+ * filter in front of another policy. Faulted pages enter a small LRU window,
+ * about 1% of memory. When the window is full, its oldest page is a
+ * candidate for the main area: it gets in only if a count-min sketch says
+ * it was referenced more often than the main area's victim, which is then
+ * evicted instead of it. So pages referenced once, like a scan, pass through
+ * the window without flushing the main area. The main area is a segmented
+ * LRU by default (a probation queue for admitted pages, and a protected one,
+ * 80% of the main area, for pages hit since), or else LRU, Clock or FIFO,
+ * unchanged, to measure what admission alone buys them.
+ * @details The sketch holds 4-bit counters, 16 per frame, in 64-byte blocks
+ * aligned to cache lines; a page's four counters, one per row, are all in
+ * the same block, so a reference touches one cache line. After 10 additions
+ * per frame every counter is halved, so old popularity fades. The window and
+ * SLRU queues are linked through VPage.meta.tinylfu; a shadow array by PPN
+ * tells which area each frame is in.
+ */
+
+#ifndef _REPLACE_TINYLFU_
+#define _REPLACE_TINYLFU_
+
+#include "memory.h"
+#include "replace-clock.h"
+#include "replace-fifo.h"
+#include "replace-lru.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+// policies the main area can be
+typedef enum tinylfu_main_t {
+    TINYLFU_SLRU,
+    TINYLFU_LRU,
+    TINYLFU_CLOCK,
+    TINYLFU_FIFO,
+} TinyLfuMain;
+
+// where a resident page is
+enum {
+    TINYLFU_WINDOW,
+    TINYLFU_PROBATION,
+    TINYLFU_PROTECTED,
+    TINYLFU_WRAPPED, // in the main area, held by the wrapped policy
+};
+
+// 128 4-bit counters, on one cache line
+typedef struct tinylfu_block_t {
+    uint64_t words[8];
+} __attribute__((aligned(64))) TinyLfuBlock;
+
+TAILQ_HEAD(tinylfu_queue_t, vpage_t);
+
+typedef struct replace_tinylfu_t {
+    // count-min sketch of references, 4 rows of 4-bit counters
+    TinyLfuBlock* sketch;
+    size_t blockMask;        // blocks - 1, blocks a power of two
+    unsigned long additions; // since the last halving
+    unsigned long sampleSize; // additions between halvings
+
+    struct tinylfu_queue_t window; // LRU, oldest on the head
+    int windowPages;
+    int windowTarget;
+
+    TinyLfuMain main;
+    int mainPages;
+    // SLRU main area, oldest on the heads
+    struct tinylfu_queue_t probation;
+    struct tinylfu_queue_t protected;
+    int protectedPages;
+    int protectedTarget;
+    // or the wrapped policy
+    union {
+        ReplaceLRU lru;
+        ReplaceClock clock;
+        ReplaceFIFO fifo;
+    } wrapped;
+
+    unsigned char* areas; // by PPN, where its page is
+    VPage** frames;       // by PPN, the page in it
+    int pages;            // size of memory in pages
+
+    // counters
+    unsigned long evictions;
+    unsigned long candidates; // window pages weighed against a victim
+    unsigned long admitted;   // candidates that won
+    unsigned long halvings;
+} ReplaceTinyLFU;
+
+/**
+ * Looks up a main area other than the default segmented LRU by name.
+ * @param name "lru", "clock" or "fifo"
+ * @return false if it isn't one of those, else true with it in *main
+ */
+bool ReplaceTinyLFU_parseMain(const char* name, TinyLfuMain* main);
+
+/** Creates the sketch, empty queues and the wrapped policy */
+void ReplaceTinyLFU_init(ReplaceTinyLFU* r, int numberOfPhysicalPages,
+                         TinyLfuMain main);
+
+/** Frees the sketch, the shadow arrays and the wrapped policy */
+void ReplaceTinyLFU_free(ReplaceTinyLFU* r);
+
+/** Prints the admissions and the sketch, then the wrapped policy's stats */
+void ReplaceTinyLFU_printStats(const ReplaceTinyLFU* r);
+
+/** Halves every counter of the sketch */
+void ReplaceTinyLFU_halve(ReplaceTinyLFU* r);
+
+/**
+ * Weighs the window's oldest page, if the window is full, against the main
+ * area's victim, and moves it into the main area if it wins
+ * @return PPN of page to evict
+ */
+unsigned long ReplaceTinyLFU_getPageToEvict(ReplaceTinyLFU* r);
+
+/** Moves a page from the window into the main area */
+void ReplaceTinyLFU_admit(ReplaceTinyLFU* r, VPage* v);
+
+/** @return a hash of a page, its block in the low bits */
+static inline uint64_t ReplaceTinyLFU_hash(const VPage* v) {
+    uint64_t h = (v->pid * 0x9E3779B97F4A7C15ULL) ^ v->vpn;
+    // MurmurHash3's 64-bit finalizer
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @return the estimated references to a page: the least of its counters,
+ * which each other page can only have added to
+ * @details O(1), one cache line
+ */
+static inline unsigned int ReplaceTinyLFU_frequency(const ReplaceTinyLFU* r,
+                                                    const VPage* v) {
+    uint64_t h = ReplaceTinyLFU_hash(v);
+    const TinyLfuBlock* b = &r->sketch[h & r->blockMask];
+    uint64_t bits = h >> 40; // counter positions, away from the block bits
+    unsigned int least = 15;
+    for (int row = 0; row < 4; row++) {
+        uint64_t word = b->words[2 * row + ((bits >> row) & 1)];
+        unsigned int shift = ((bits >> (4 + 4 * row)) & 15) * 4;
+        unsigned int count = (word >> shift) & 15;
+        if (count < least) least = count;
+    }
+    return least;
+}
+
+/**
+ * Counts a reference to a page, halving the sketch once enough were counted
+ * @details O(1), one cache line, amortized
+ */
+static inline void ReplaceTinyLFU_count(ReplaceTinyLFU* r, const VPage* v) {
+    uint64_t h = ReplaceTinyLFU_hash(v);
+    TinyLfuBlock* b = &r->sketch[h & r->blockMask];
+    uint64_t bits = h >> 40;
+    bool added = false;
+    for (int row = 0; row < 4; row++) {
+        uint64_t* word = &b->words[2 * row + ((bits >> row) & 1)];
+        unsigned int shift = ((bits >> (4 + 4 * row)) & 15) * 4;
+        if (((*word >> shift) & 15) < 15) {
+            *word += (uint64_t)1 << shift;
+            added = true;
+        }
+    }
+    if (added && ++r->additions >= r->sampleSize) ReplaceTinyLFU_halve(r);
+}
+
+/**
+ * Counts the reference, and moves the page up within its area: to the tail
+ * of the window or protected queue, from probation to protected, or as the
+ * wrapped policy does
+ * @details O(1)
+ */
+static inline void ReplaceTinyLFU_notifyPageAccess(ReplaceTinyLFU* r,
+                                                   VPage* v) {
+    assert(v->inMemory);
+    ReplaceTinyLFU_count(r, v);
+    switch (r->areas[v->currentPPN]) {
+    case TINYLFU_WINDOW:
+        TAILQ_REMOVE(&r->window, v, meta.tinylfu.entries);
+        TAILQ_INSERT_TAIL(&r->window, v, meta.tinylfu.entries);
+        break;
+    case TINYLFU_PROTECTED:
+        TAILQ_REMOVE(&r->protected, v, meta.tinylfu.entries);
+        TAILQ_INSERT_TAIL(&r->protected, v, meta.tinylfu.entries);
+        break;
+    case TINYLFU_PROBATION:
+        TAILQ_REMOVE(&r->probation, v, meta.tinylfu.entries);
+        TAILQ_INSERT_TAIL(&r->protected, v, meta.tinylfu.entries);
+        r->areas[v->currentPPN] = TINYLFU_PROTECTED;
+        r->protectedPages++;
+        if (r->protectedPages > r->protectedTarget) {
+            // the oldest protected page goes back on probation
+            VPage* demoted = TAILQ_FIRST(&r->protected);
+            TAILQ_REMOVE(&r->protected, demoted, meta.tinylfu.entries);
+            TAILQ_INSERT_TAIL(&r->probation, demoted, meta.tinylfu.entries);
+            r->areas[demoted->currentPPN] = TINYLFU_PROBATION;
+            r->protectedPages--;
+        }
+        break;
+    case TINYLFU_WRAPPED:
+        switch (r->main) {
+        case TINYLFU_LRU:
+            ReplaceLRU_notifyPageAccess(&r->wrapped.lru, v);
+            break;
+        case TINYLFU_CLOCK:
+            ReplaceClock_notifyPageAccess(&r->wrapped.clock, v);
+            break;
+        case TINYLFU_FIFO:
+            ReplaceFIFO_notifyPageAccess(&r->wrapped.fifo, v);
+            break;
+        default: assert(false);
+        }
+        break;
+    default: assert(false);
+    }
+}
+
+/**
+ * Counts the reference that missed
+ * @details O(1)
+ */
+static inline void ReplaceTinyLFU_notifyPageFault(ReplaceTinyLFU* r,
+                                                  VPage* v) {
+    ReplaceTinyLFU_count(r, v);
+}
+
+/**
+ * Enqueue the page on the window. While memory is filling up, nothing is
+ * evicted, so a window that outgrows its share passes its oldest page on to
+ * the main area, unweighed.
+ * @details O(1)
+ */
+static inline void ReplaceTinyLFU_notifyPageLoad(ReplaceTinyLFU* r,
+                                                 VPage* v) {
+    assert(v->inMemory);
+    TAILQ_INSERT_TAIL(&r->window, v, meta.tinylfu.entries);
+    r->windowPages++;
+    r->areas[v->currentPPN] = TINYLFU_WINDOW;
+    r->frames[v->currentPPN] = v;
+    if (r->windowPages > r->windowTarget) {
+        ReplaceTinyLFU_admit(r, TAILQ_FIRST(&r->window));
+    }
+}
+
+/**
+ * Remove the page from its area
+ * @details O(1)
+ */
+static inline void ReplaceTinyLFU_notifyPageEvict(ReplaceTinyLFU* r,
+                                                  VPage* v) {
+    assert(v->inMemory);
+    switch (r->areas[v->currentPPN]) {
+    case TINYLFU_WINDOW:
+        TAILQ_REMOVE(&r->window, v, meta.tinylfu.entries);
+        r->windowPages--;
+        break;
+    case TINYLFU_PROTECTED:
+        TAILQ_REMOVE(&r->protected, v, meta.tinylfu.entries);
+        r->protectedPages--;
+        r->mainPages--;
+        break;
+    case TINYLFU_PROBATION:
+        TAILQ_REMOVE(&r->probation, v, meta.tinylfu.entries);
+        r->mainPages--;
+        break;
+    case TINYLFU_WRAPPED:
+        switch (r->main) {
+        case TINYLFU_LRU:
+            ReplaceLRU_notifyPageEvict(&r->wrapped.lru, v);
+            break;
+        case TINYLFU_CLOCK:
+            ReplaceClock_notifyPageEvict(&r->wrapped.clock, v);
+            break;
+        case TINYLFU_FIFO:
+            ReplaceFIFO_notifyPageEvict(&r->wrapped.fifo, v);
+            break;
+        default: assert(false);
+        }
+        r->mainPages--;
+        break;
+    default: assert(false);
+    }
+    r->frames[v->currentPPN] = NULL;
+}
+
+#endif
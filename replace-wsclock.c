@@ -0,0 +1,83 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-wsclock.c
+ * @brief Replacement module implementing WSClock. Overhead is tied to
+ * physical pages, in a shadow array of frames on memory.
+ * @details the hooks other than eviction are inline, in replace-wsclock.h
+ */
+
+#include "replace-wsclock.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void ReplaceWSClock_init(ReplaceWSClock* r, int numberOfPhysicalPages,
+                         unsigned long tau) {
+    r->pages = numberOfPhysicalPages;
+    r->frames = calloc(r->pages, sizeof(WsclockFrame));
+    if (r->frames == NULL) {
+        perror("Cannot allocate memory for WSClock frames.");
+        exit(EXIT_FAILURE);
+    }
+    r->hand = 0;
+    r->residents = 0;
+    r->tau = tau;
+    r->evictions = 0;
+    r->travel = 0;
+    r->fallbacks = 0;
+}
+
+void ReplaceWSClock_free(ReplaceWSClock* r) {
+    free(r->frames);
+    r->frames = NULL;
+}
+
+void ReplaceWSClock_printStats(const ReplaceWSClock* r) {
+    printf("  \x1B[96mwsclock hand travel:\x1B[0m %.2f frames per "
+           "eviction\n",
+           r->evictions ? (double)r->travel / r->evictions : 0.0);
+    if (r->tau != 0) {
+        printf("  \x1B[96mwsclock working sets:\x1B[0m tau %lu references",
+               r->tau);
+    } else {
+        printf("  \x1B[96mwsclock working sets:\x1B[0m tau the frames per "
+               "process");
+    }
+    printf(", %lu of %lu victims still inside\n", r->fallbacks,
+           r->evictions);
+}
+
+unsigned long ReplaceWSClock_getPageToEvict(ReplaceWSClock* r) {
+    r->evictions++;
+    ul64 tau = ReplaceWSClock_tau(r);
+    long oldest = -1;
+    ul64 oldestAge = 0;
+
+    // one sweep clears every bit, so a second always finds an oldest page
+    for (int moved = 0; moved < 2 * r->pages; moved++) {
+        if (oldest >= 0 && (moved >= WSCLOCK_SCAN || moved >= r->pages)) {
+            break; // settle for the oldest seen
+        }
+        unsigned long ppn = r->hand;
+        WsclockFrame* f = &r->frames[ppn];
+        assert(f->page != NULL && "memory should be full");
+        r->hand = (r->hand + 1) % r->pages;
+        r->travel++;
+
+        ul64 now = f->page->owner->virtualTime;
+        if (f->referenced) {
+            f->referenced = false;
+            f->lastUse = now;
+            continue;
+        }
+        ul64 age = now - f->lastUse;
+        if (age > tau) return ppn;
+        if (oldest < 0 || age > oldestAge) {
+            oldest = ppn;
+            oldestAge = age;
+        }
+    }
+
+    assert(oldest >= 0);
+    r->fallbacks++;
+    return oldest;
+}
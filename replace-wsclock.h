@@ -0,0 +1,112 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace-wsclock.h
+ * @brief Inline hooks of WSClock (Carr and Hennessy, SOSP '81), the working
+ * set policy run with a clock hand. Each frame has a reference bit and the
+ * last-use time of its page, in the virtual time of the page's process (the
+ * references that process has run, see ResidentSet). The hand clears set
+ * bits, stamping the frame with its owner's current time, and evicts the
+ * first page that has gone unreferenced for more than tau references of its
+ * own process. Pages age only while their process runs, so a process
+ * scanning through memory ages its own pages out, not everyone else's.
+ * @details tau defaults to the frames per resident process, a window in
+ * which no process can reference more pages than its share of memory. If
+ * WSCLOCK_SCAN frames go by without a page outside its working set, the
+ * oldest unreferenced page seen goes instead, so a fault never has to walk
+ * all of memory. Frames are a shadow array by PPN, like Clock's bits; a hit
+ * only sets a bit.
+ */
+
+#ifndef _REPLACE_WSCLOCK_
+#define _REPLACE_WSCLOCK_
+
+#include "memory.h"
+#include <assert.h>
+#include <stdbool.h>
+
+#define WSCLOCK_SCAN 64 // frames looked at before settling for the oldest
+
+typedef struct wsclock_frame_t {
+    VPage* page;
+    ul64 lastUse; // owner's virtual time when last seen referenced
+    bool referenced;
+} WsclockFrame;
+
+typedef struct replace_wsclock_t {
+    WsclockFrame* frames; // by PPN
+    unsigned long hand;
+    int pages;     // size of memory in pages
+    int residents; // processes with a page in memory
+    ul64 tau; // working set window, in references of the owning process, or
+              // 0 for the frames per resident process
+
+    // counters
+    unsigned long evictions;
+    unsigned long travel;    // frames the hand moved past
+    unsigned long fallbacks; // victims still in their working set
+} ReplaceWSClock;
+
+/**
+ * Creates the frame array, with the hand at PPN 0
+ * @param tau references of a process after which its unreferenced pages
+ * leave its working set, or 0 for the default, the frames per resident
+ * process
+ */
+void ReplaceWSClock_init(ReplaceWSClock* r, int numberOfPhysicalPages,
+                         unsigned long tau);
+
+/** Frees the frame array */
+void ReplaceWSClock_free(ReplaceWSClock* r);
+
+/** Prints the hand travel per eviction and how often tau had to give */
+void ReplaceWSClock_printStats(const ReplaceWSClock* r);
+
+/** @return the working set window, in references, for the next eviction */
+static inline ul64 ReplaceWSClock_tau(const ReplaceWSClock* r) {
+    if (r->tau != 0) return r->tau;
+    return (ul64)r->pages / (r->residents > 0 ? r->residents : 1);
+}
+
+/**
+ * Sweeps from the hand for a page outside its working set
+ * @return PPN of page to evict
+ */
+unsigned long ReplaceWSClock_getPageToEvict(ReplaceWSClock* r);
+
+/**
+ * Turn the reference bit on
+ * @details O(1)
+ */
+static inline void ReplaceWSClock_notifyPageAccess(ReplaceWSClock* r,
+                                                   VPage* v) {
+    assert(v->inMemory);
+    r->frames[v->currentPPN].referenced = true;
+}
+
+/**
+ * A newly loaded page starts out referenced, and used now
+ * @details O(1)
+ */
+static inline void ReplaceWSClock_notifyPageLoad(ReplaceWSClock* r,
+                                                 VPage* v) {
+    assert(v->inMemory && v->owner != NULL);
+    if (v->owner->pages == 1) r->residents++; // its first
+    WsclockFrame* f = &r->frames[v->currentPPN];
+    f->page = v;
+    f->lastUse = v->owner->virtualTime;
+    f->referenced = true;
+}
+
+/**
+ * Empty the frame
+ * @details O(1)
+ */
+static inline void ReplaceWSClock_notifyPageEvict(ReplaceWSClock* r,
+                                                  VPage* v) {
+    assert(v->inMemory && v->owner != NULL);
+    if (v->owner->pages == 1) r->residents--; // its last, not yet counted
+    r->frames[v->currentPPN].page = NULL;
+    r->frames[v->currentPPN].referenced = false;
+}
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file replace.c
+ * @brief Setup and teardown of a replacement policy instance; the hooks
+ * called per reference are inline, in replace.h
+ */
+
+#include "replace.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const policyNames[NUM_REPLACE_POLICIES] = {
+  [REPLACE_LRU] = "lru",
+  [REPLACE_FIFO] = "fifo",
+  [REPLACE_CLOCK] = "clock",
+  [REPLACE_RANDOM] = "random",
+  [REPLACE_ARC] = "arc",
+  [REPLACE_CLOCKPRO] = "clockpro",
+  [REPLACE_LIRS] = "lirs",
+  [REPLACE_OPT] = "opt",
+  [REPLACE_LFU] = "lfu",
+  [REPLACE_WSCLOCK] = "wsclock",
+  [REPLACE_PFF] = "pff",
+  [REPLACE_SAMPLED] = "sampled",
+  [REPLACE_MGLRU] = "mglru",
+  [REPLACE_S3FIFO] = "s3fifo",
+  [REPLACE_TINYLFU] = "tinylfu",
+};
+
+void Replace_init(Replace* r, const ReplaceSpec* spec, Memory* memory) {
+    int pages = Memory_getTotalSize(memory);
+    r->policy = spec->policy;
+    r->memory = memory;
+    switch (spec->policy) {
+    case REPLACE_LRU: ReplaceLRU_init(&r->lru, pages); break;
+    case REPLACE_FIFO: ReplaceFIFO_init(&r->fifo, pages); break;
+    case REPLACE_CLOCK: ReplaceClock_init(&r->clock, pages); break;
+    case REPLACE_RANDOM:
+        ReplaceRandom_init(&r->random, pages, spec->seed);
+        break;
+    case REPLACE_ARC: ReplaceARC_init(&r->arc, pages); break;
+    case REPLACE_CLOCKPRO: ReplaceClockPro_init(&r->clockpro, pages); break;
+    case REPLACE_LIRS: ReplaceLIRS_init(&r->lirs, pages); break;
+    case REPLACE_OPT: ReplaceOPT_init(&r->opt, pages); break;
+    case REPLACE_LFU:
+        ReplaceLFU_init(&r->lfu, pages, spec->parameter);
+        break;
+    case REPLACE_WSCLOCK:
+        ReplaceWSClock_init(&r->wsclock, pages, spec->parameter);
+        break;
+    case REPLACE_PFF: ReplacePFF_init(&r->pff, pages, spec->parameter); break;
+    case REPLACE_SAMPLED:
+        ReplaceSampled_init(&r->sampled, pages, spec->parameter, spec->seed);
+        break;
+    case REPLACE_MGLRU: ReplaceMGLRU_init(&r->mglru, pages); break;
+    case REPLACE_S3FIFO: ReplaceS3FIFO_init(&r->s3fifo, pages); break;
+    case REPLACE_TINYLFU:
+        ReplaceTinyLFU_init(&r->tinylfu, pages, (TinyLfuMain)spec->parameter);
+        break;
+    default:
+        fprintf(stderr, "Unknown replacement policy %d.\n", spec->policy);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void Replace_free(Replace* r) {
+    switch (r->policy) {
+    case REPLACE_LRU: ReplaceLRU_free(&r->lru); break;
+    case REPLACE_FIFO: ReplaceFIFO_free(&r->fifo); break;
+    case REPLACE_CLOCK: ReplaceClock_free(&r->clock); break;
+    case REPLACE_RANDOM: ReplaceRandom_free(&r->random); break;
+    case REPLACE_ARC: ReplaceARC_free(&r->arc); break;
+    case REPLACE_CLOCKPRO: ReplaceClockPro_free(&r->clockpro); break;
+    case REPLACE_LIRS: ReplaceLIRS_free(&r->lirs); break;
+    case REPLACE_OPT: ReplaceOPT_free(&r->opt); break;
+    case REPLACE_LFU: ReplaceLFU_free(&r->lfu); break;
+    case REPLACE_WSCLOCK: ReplaceWSClock_free(&r->wsclock); break;
+    case REPLACE_PFF: ReplacePFF_free(&r->pff); break;
+    case REPLACE_SAMPLED: ReplaceSampled_free(&r->sampled); break;
+    case REPLACE_MGLRU: ReplaceMGLRU_free(&r->mglru); break;
+    case REPLACE_S3FIFO: ReplaceS3FIFO_free(&r->s3fifo); break;
+    case REPLACE_TINYLFU: ReplaceTinyLFU_free(&r->tinylfu); break;
+    default: break;
+    }
+}
+
+void Replace_printStats(const Replace* r) {
+    switch (r->policy) {
+    case REPLACE_CLOCK: ReplaceClock_printStats(&r->clock); break;
+    case REPLACE_ARC: ReplaceARC_printStats(&r->arc); break;
+    case REPLACE_CLOCKPRO: ReplaceClockPro_printStats(&r->clockpro); break;
+    case REPLACE_LIRS: ReplaceLIRS_printStats(&r->lirs); break;
+    case REPLACE_OPT: ReplaceOPT_printStats(&r->opt); break;
+    case REPLACE_LFU: ReplaceLFU_printStats(&r->lfu); break;
+    case REPLACE_WSCLOCK: ReplaceWSClock_printStats(&r->wsclock); break;
+    case REPLACE_PFF: ReplacePFF_printStats(&r->pff); break;
+    case REPLACE_SAMPLED: ReplaceSampled_printStats(&r->sampled); break;
+    case REPLACE_MGLRU: ReplaceMGLRU_printStats(&r->mglru); break;
+    case REPLACE_S3FIFO: ReplaceS3FIFO_printStats(&r->s3fifo); break;
+    case REPLACE_TINYLFU: ReplaceTinyLFU_printStats(&r->tinylfu); break;
+    default: break;
+    }
+}
+
+const char* Replace_policyName(ReplacePolicy policy) {
+    return policy < NUM_REPLACE_POLICIES ? policyNames[policy] : "?";
+}
+
+bool Replace_parsePolicy(const char* name, ReplaceSpec* spec) {
+    const char* colon = strchr(name, ':');
+    size_t length = colon != NULL ? (size_t)(colon - name) : strlen(name);
+    int found = -1;
+    for (int i = 0; i < NUM_REPLACE_POLICIES; i++) {
+        if (strlen(policyNames[i]) == length
+            && strncmp(name, policyNames[i], length) == 0) {
+            found = i;
+        }
+    }
+    if (found < 0 || strlen(name) >= REPLACE_NAME_LENGTH) return false;
+    spec->policy = found;
+    spec->parameter = 0;
+    spec->seed = 1;
+    strcpy(spec->name, name);
+    if (colon == NULL) return true;
+    if (spec->policy == REPLACE_TINYLFU) {
+        TinyLfuMain main;
+        if (!ReplaceTinyLFU_parseMain(colon + 1, &main)) return false;
+        spec->parameter = main; // TINYLFU_SLRU, 0, when not given
+        return true;
+    }
+
+    // strtoul would take a sign, or spaces before one, and negate the value
+    if (!isdigit((unsigned char)colon[1])) return false;
+    char* end;
+    errno = 0;
+    unsigned long parameter = strtoul(colon + 1, &end, 10);
+    if (errno != 0 || *end != '\0') return false;
+    switch (spec->policy) {
+    case REPLACE_SAMPLED:
+        if (parameter > INT_MAX) return false; // K is an int
+        // fall through
+    case REPLACE_LFU:
+    case REPLACE_WSCLOCK:
+    case REPLACE_PFF: spec->parameter = parameter; return true;
+    default: return false; // takes no parameter
+    }
+}
+
+int Replace_parsePolicyList(char* list, ReplaceSpec* specs) {
+    int n = 0;
+    char* save = NULL;
+    for (char* name = strtok_r(list, ",", &save); name != NULL;
+         name = strtok_r(NULL, ",", &save)) {
+        ReplaceSpec* spec = &specs[n];
+        if (n == REPLACE_MAX_POLICIES || !Replace_parsePolicy(name, spec)) {
+            return 0;
+        }
+        for (int i = 0; i < n; i++) {
+            if (specs[i].policy == spec->policy
+                && specs[i].parameter == spec->parameter) {
+                return 0; // listed twice
+            }
+        }
+        n++;
+    }
+    return n;
+}
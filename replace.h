@@ -4,55 +4,318 @@
  * @brief Replacement module interface, defines a common set of interface functions
  *  which all implementations can make use of.
  * @author Julien de Castelnau and Michael Noguera
+ * @details A Replace is one instance of a policy, chosen at run time. Each
+ * policy keeps its per-page state inline in the VPage (see ReplaceMeta in
+ * memory.h), its other state in its own struct, and defines the per-reference
+ * hooks as static inline functions in its own header, replace-<policy>.h.
+ * The hooks below switch on the policy and call straight into those, so the
+ * only cost of choosing at run time is one well-predicted branch.
+ *
+ * Page lifecycle, as seen by a policy:
+ *  - Replace_notifyNextUse: the page is being referenced, and this is when
+ *    it will be next; only for OPT, from the next-use index
+ *  - Replace_notifyPageFault: the page missed, and is about to be loaded
+ *    (evicting another, if memory is full)
+ *  - Replace_notifyPageLoad: the page was just loaded into a frame
+ *  - Replace_notifyPageAccess: the page was hit
+ *  - Replace_notifyPageRetry: the reference that faulted ran again once its
+ *    page was loaded, which the simulator counts as a hit
+ *  - Replace_getPageToEvict: memory is full, pick a victim (without
+ *    removing it, the caller evicts it next)
+ *  - Replace_notifyPageEvict: the page is leaving its frame, whether it was
+ *    picked as a victim or its process finished
  */
 
+#ifndef _REPLACE_
+#define _REPLACE_
+
 #include "memory.h"
+#include "replace-arc.h"
+#include "replace-clock.h"
+#include "replace-clockpro.h"
+#include "replace-fifo.h"
+#include "replace-lfu.h"
+#include "replace-lirs.h"
+#include "replace-lru.h"
+#include "replace-mglru.h"
+#include "replace-opt.h"
+#include "replace-pff.h"
+#include "replace-random.h"
+#include "replace-s3fifo.h"
+#include "replace-tinylfu.h"
+#include "replace-sampled.h"
+#include "replace-wsclock.h"
+#include <assert.h>
+
+typedef enum ReplacePolicy {
+    REPLACE_LRU,
+    REPLACE_FIFO,
+    REPLACE_CLOCK,
+    REPLACE_RANDOM,
+    REPLACE_ARC,
+    REPLACE_CLOCKPRO,
+    REPLACE_LIRS,
+    REPLACE_OPT,
+    REPLACE_LFU,
+    REPLACE_WSCLOCK,
+    REPLACE_PFF,
+    REPLACE_SAMPLED,
+    REPLACE_MGLRU,
+    REPLACE_S3FIFO,
+    REPLACE_TINYLFU,
+    NUM_REPLACE_POLICIES
+} ReplacePolicy;
+
+// every policy name, for usage and error messages, wrapped to start a line
+#define REPLACE_POLICY_NAMES \
+    "lru, fifo, clock, random, arc, clockpro, lirs,\n\topt, lfu[:N], " \
+    "wsclock[:N], pff[:N], sampled[:K],\n\tmglru, s3fifo or "             \
+    "tinylfu[:lru|clock|fifo]"
+
+// most policies in one -a list, which may repeat one with other parameters
+#define REPLACE_MAX_POLICIES 32
+#define REPLACE_NAME_LENGTH 32
+
+// A policy as named on the command line, e.g. "lfu:1000"
+typedef struct replace_spec_t {
+    ReplacePolicy policy;
+    unsigned long parameter; // given after the colon, 0 for the default
+    uint64_t seed; // for policies that draw frames at random, 1 by default
+    char name[REPLACE_NAME_LENGTH]; // as given, for output
+} ReplaceSpec;
+
+typedef struct replace_t {
+    ReplacePolicy policy;
+    Memory* memory; // the memory whose frames this instance picks from
+    union {
+        ReplaceLRU lru;
+        ReplaceFIFO fifo;
+        ReplaceClock clock;
+        ReplaceRandom random;
+        ReplaceARC arc;
+        ReplaceClockPro clockpro;
+        ReplaceLIRS lirs;
+        ReplaceOPT opt;
+        ReplaceLFU lfu;
+        ReplaceWSClock wsclock;
+        ReplacePFF pff;
+        ReplaceSampled sampled;
+        ReplaceMGLRU mglru;
+        ReplaceS3FIFO s3fifo;
+        ReplaceTinyLFU tinylfu;
+    };
+} Replace;
 
 /**
- * Initializes general replacement module overhead, if any.
+ * Initializes a replacement policy instance for a given memory.
  * @details run before page allocation starts
  */
-void Replace_initReplacementModule(int numberOfPhysicalPages);
+void Replace_init(Replace* r, const ReplaceSpec* spec, Memory* memory);
 
 /**
- * A generic constructor method for overhead struct
- * @return A void pointer to a new overhead struct
+ * Cleans up policy overhead
+ * @details run after simulation complete
  */
-void* Replace_initOverhead(VPage* vpage);
+void Replace_free(Replace* r);
 
 /**
- * A generic destructor method for overhead struct
- * @param o_ptr A void* holding the overhead struct
+ * Prints the policy's own counters, if it keeps any, one line each and
+ * labelled with the policy's name
  */
-void Replace_freeOverhead(void* o_ptr);
+void Replace_printStats(const Replace* r);
 
 /**
- * Cleans up module overhead
- * @details run after simulation complete
+ * @return the name of a policy, as accepted by Replace_parsePolicy
  */
-void Replace_freeReplacementModule();
+const char* Replace_policyName(ReplacePolicy policy);
 
 /**
- * A generic method to update any overhead/tracking information the
- * implementation algorithm might need, such as the last access time, or the
- * clock reference bit, when the page is accessed.
- * @details Called once after every page hit in simulator.c
- * @param o_ptr A void* holding the overhead struct
+ * Looks up a policy by name. Policies with a parameter also take it after
+ * a colon, which only applies to instances made from this spec: "lfu:N"
+ * decays counts every N references, "wsclock:N" sets tau to N references,
+ * "pff:N" sets the fault interval threshold to N references and "sampled:K"
+ * draws K frames per eviction. "tinylfu:lru", "tinylfu:clock" and
+ * "tinylfu:fifo" put TinyLFU's admission in front of that policy instead of
+ * its segmented LRU.
+ * @return true if found, with the policy and its parameter stored in *spec
  */
-void Replace_notifyPageAccess(void* o_ptr);
+bool Replace_parsePolicy(const char* name, ReplaceSpec* spec);
 
 /**
- * Another generic method to update any overhead/tracking information the
- * implementation algorithm might need, such as the last access time, or the
- * clock reference bit, when the page is not in memory.
- * @details Called once after every page load (after disk I/O completes) in simulator.c
- * @param o_ptr A void* holding the overhead struct
+ * Parses a comma separated list of policy names, as given to -a. A policy
+ * may be listed more than once with different parameters. The list is
+ * modified.
+ * @param[out] specs parsed policies, at most REPLACE_MAX_POLICIES
+ * @return number of policies, or 0 if the list is invalid
  */
-void Replace_notifyPageLoad(void* o_ptr);
+int Replace_parsePolicyList(char* list, ReplaceSpec* specs);
 
 /**
- * Core "replacement algorithm" method. Uses the corresponding module's
- * algorithm to choose a victim.
- * @return ppn of page to evict
+ * The page is being referenced, by the reference that faulted on it if it
+ * isn't resident, and will next be referenced at trace line line, or never
+ * (REF_NEVER). Called before the other hooks, only when the simulator has a
+ * next-use index (see first_pass_nextUse).
  */
-unsigned long Replace_getPageToEvict();
+static inline void Replace_notifyNextUse(Replace* r, VPage* v,
+                                         unsigned long line) {
+    switch (r->policy) {
+    case REPLACE_OPT: ReplaceOPT_notifyNextUse(&r->opt, v, line); break;
+    default: break; // only OPT looks ahead
+    }
+}
+
+/** The page was hit */
+static inline void Replace_notifyPageAccess(Replace* r, VPage* v) {
+    switch (r->policy) {
+    case REPLACE_LRU: ReplaceLRU_notifyPageAccess(&r->lru, v); break;
+    case REPLACE_FIFO: ReplaceFIFO_notifyPageAccess(&r->fifo, v); break;
+    case REPLACE_CLOCK: ReplaceClock_notifyPageAccess(&r->clock, v); break;
+    case REPLACE_RANDOM: ReplaceRandom_notifyPageAccess(&r->random, v); break;
+    case REPLACE_ARC: ReplaceARC_notifyPageAccess(&r->arc, v); break;
+    case REPLACE_CLOCKPRO:
+        ReplaceClockPro_notifyPageAccess(&r->clockpro, v);
+        break;
+    case REPLACE_LIRS: ReplaceLIRS_notifyPageAccess(&r->lirs, v); break;
+    case REPLACE_OPT: ReplaceOPT_notifyPageAccess(&r->opt, v); break;
+    case REPLACE_LFU: ReplaceLFU_notifyPageAccess(&r->lfu, v); break;
+    case REPLACE_WSCLOCK:
+        ReplaceWSClock_notifyPageAccess(&r->wsclock, v);
+        break;
+    case REPLACE_PFF: ReplacePFF_notifyPageAccess(&r->pff, v); break;
+    case REPLACE_SAMPLED:
+        ReplaceSampled_notifyPageAccess(&r->sampled, v);
+        break;
+    case REPLACE_MGLRU: ReplaceMGLRU_notifyPageAccess(&r->mglru, v); break;
+    case REPLACE_S3FIFO: ReplaceS3FIFO_notifyPageAccess(&r->s3fifo, v); break;
+    case REPLACE_TINYLFU:
+        ReplaceTinyLFU_notifyPageAccess(&r->tinylfu, v);
+        break;
+    default: assert(false);
+    }
+}
+
+/**
+ * The reference that faulted on the page ran again, now that it is loaded.
+ * It is the same reference as the fault, so policies that tell pages apart by
+ * their references ignore it; LRU, FIFO, Clock and Random have always taken
+ * it as a hit, and still do.
+ */
+static inline void Replace_notifyPageRetry(Replace* r, VPage* v) {
+    switch (r->policy) {
+    case REPLACE_ARC:
+    case REPLACE_CLOCKPRO:
+    case REPLACE_LIRS:
+    case REPLACE_LFU:
+    case REPLACE_MGLRU:
+    case REPLACE_S3FIFO:
+    case REPLACE_TINYLFU: break;
+    default: Replace_notifyPageAccess(r, v); break;
+    }
+}
+
+/**
+ * The page missed. Called before a frame is found for it, so policies that
+ * treat pages differently by their history can pick a victim accordingly.
+ */
+static inline void Replace_notifyPageFault(Replace* r, VPage* v) {
+    switch (r->policy) {
+    case REPLACE_ARC: ReplaceARC_notifyPageFault(&r->arc, v); break;
+    case REPLACE_CLOCKPRO:
+        ReplaceClockPro_notifyPageFault(&r->clockpro, v);
+        break;
+    case REPLACE_LIRS: ReplaceLIRS_notifyPageFault(&r->lirs, v); break;
+    case REPLACE_PFF: ReplacePFF_notifyPageFault(&r->pff, v); break;
+    case REPLACE_TINYLFU:
+        ReplaceTinyLFU_notifyPageFault(&r->tinylfu, v);
+        break;
+    default: break; // most policies only act once the page is loaded
+    }
+}
+
+/** The page was just loaded into a frame */
+static inline void Replace_notifyPageLoad(Replace* r, VPage* v) {
+    switch (r->policy) {
+    case REPLACE_LRU: ReplaceLRU_notifyPageLoad(&r->lru, v); break;
+    case REPLACE_FIFO: ReplaceFIFO_notifyPageLoad(&r->fifo, v); break;
+    case REPLACE_CLOCK: ReplaceClock_notifyPageLoad(&r->clock, v); break;
+    case REPLACE_RANDOM: ReplaceRandom_notifyPageLoad(&r->random, v); break;
+    case REPLACE_ARC: ReplaceARC_notifyPageLoad(&r->arc, v); break;
+    case REPLACE_CLOCKPRO:
+        ReplaceClockPro_notifyPageLoad(&r->clockpro, v);
+        break;
+    case REPLACE_LIRS: ReplaceLIRS_notifyPageLoad(&r->lirs, v); break;
+    case REPLACE_OPT: ReplaceOPT_notifyPageLoad(&r->opt, v); break;
+    case REPLACE_LFU: ReplaceLFU_notifyPageLoad(&r->lfu, v); break;
+    case REPLACE_WSCLOCK:
+        ReplaceWSClock_notifyPageLoad(&r->wsclock, v);
+        break;
+    case REPLACE_PFF: ReplacePFF_notifyPageLoad(&r->pff, v); break;
+    case REPLACE_SAMPLED:
+        ReplaceSampled_notifyPageLoad(&r->sampled, v);
+        break;
+    case REPLACE_MGLRU: ReplaceMGLRU_notifyPageLoad(&r->mglru, v); break;
+    case REPLACE_S3FIFO: ReplaceS3FIFO_notifyPageLoad(&r->s3fifo, v); break;
+    case REPLACE_TINYLFU:
+        ReplaceTinyLFU_notifyPageLoad(&r->tinylfu, v);
+        break;
+    default: assert(false);
+    }
+}
+
+/** The page is leaving its frame */
+static inline void Replace_notifyPageEvict(Replace* r, VPage* v) {
+    switch (r->policy) {
+    case REPLACE_LRU: ReplaceLRU_notifyPageEvict(&r->lru, v); break;
+    case REPLACE_FIFO: ReplaceFIFO_notifyPageEvict(&r->fifo, v); break;
+    case REPLACE_CLOCK: ReplaceClock_notifyPageEvict(&r->clock, v); break;
+    case REPLACE_RANDOM: ReplaceRandom_notifyPageEvict(&r->random, v); break;
+    case REPLACE_ARC: ReplaceARC_notifyPageEvict(&r->arc, v); break;
+    case REPLACE_CLOCKPRO:
+        ReplaceClockPro_notifyPageEvict(&r->clockpro, v);
+        break;
+    case REPLACE_LIRS: ReplaceLIRS_notifyPageEvict(&r->lirs, v); break;
+    case REPLACE_OPT: ReplaceOPT_notifyPageEvict(&r->opt, v); break;
+    case REPLACE_LFU: ReplaceLFU_notifyPageEvict(&r->lfu, v); break;
+    case REPLACE_WSCLOCK:
+        ReplaceWSClock_notifyPageEvict(&r->wsclock, v);
+        break;
+    case REPLACE_PFF: ReplacePFF_notifyPageEvict(&r->pff, v); break;
+    case REPLACE_SAMPLED:
+        ReplaceSampled_notifyPageEvict(&r->sampled, v);
+        break;
+    case REPLACE_MGLRU: ReplaceMGLRU_notifyPageEvict(&r->mglru, v); break;
+    case REPLACE_S3FIFO: ReplaceS3FIFO_notifyPageEvict(&r->s3fifo, v); break;
+    case REPLACE_TINYLFU:
+        ReplaceTinyLFU_notifyPageEvict(&r->tinylfu, v);
+        break;
+    default: assert(false);
+    }
+}
+
+/**
+ * Picks a victim. Only called when memory is full.
+ * @return PPN of page frame to evict
+ */
+static inline unsigned long Replace_getPageToEvict(Replace* r) {
+    assert(!Memory_hasFreePage(r->memory));
+    switch (r->policy) {
+    case REPLACE_LRU: return ReplaceLRU_getPageToEvict(&r->lru);
+    case REPLACE_FIFO: return ReplaceFIFO_getPageToEvict(&r->fifo);
+    case REPLACE_CLOCK: return ReplaceClock_getPageToEvict(&r->clock);
+    case REPLACE_RANDOM: return ReplaceRandom_getPageToEvict(&r->random);
+    case REPLACE_ARC: return ReplaceARC_getPageToEvict(&r->arc);
+    case REPLACE_CLOCKPRO: return ReplaceClockPro_getPageToEvict(&r->clockpro);
+    case REPLACE_LIRS: return ReplaceLIRS_getPageToEvict(&r->lirs);
+    case REPLACE_OPT: return ReplaceOPT_getPageToEvict(&r->opt);
+    case REPLACE_LFU: return ReplaceLFU_getPageToEvict(&r->lfu);
+    case REPLACE_WSCLOCK: return ReplaceWSClock_getPageToEvict(&r->wsclock);
+    case REPLACE_PFF: return ReplacePFF_getPageToEvict(&r->pff);
+    case REPLACE_SAMPLED: return ReplaceSampled_getPageToEvict(&r->sampled);
+    case REPLACE_MGLRU: return ReplaceMGLRU_getPageToEvict(&r->mglru);
+    case REPLACE_S3FIFO: return ReplaceS3FIFO_getPageToEvict(&r->s3fifo);
+    case REPLACE_TINYLFU: return ReplaceTinyLFU_getPageToEvict(&r->tinylfu);
+    default: assert(false); return 0;
+    }
+}
+
+#endif
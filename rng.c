@@ -0,0 +1,19 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file rng.c
+ * @brief Seeding of the xoshiro256** generator.
+ */
+
+#include "rng.h"
+
+void Rng_init(Rng* g, uint64_t seed) {
+    // the state is filled with splitmix64, as xoshiro's authors recommend, so
+    // that similar seeds still give unrelated, never all-zero, states
+    uint64_t x = seed;
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        g->s[i] = z ^ (z >> 31);
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file rng.h
+ * @brief A small, fast pseudo-random generator, xoshiro256** (Blackman and
+ * Vigna), for policies that draw frames at random. Each policy instance owns
+ * its generator, so simulators running side by side never share one and
+ * every run with the same seed draws the same sequence.
+ * @details Not a cryptographic generator; predictability has no impact on
+ * security here, and determinism is useful for testing.
+ */
+
+#ifndef _RNG_
+#define _RNG_
+
+#include <stdint.h>
+
+typedef struct rng_t {
+    uint64_t s[4];
+} Rng;
+
+/**
+ * Seeds a generator
+ * @param seed any value
+ */
+void Rng_init(Rng* g, uint64_t seed);
+
+static inline uint64_t Rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/** @return the next 64 random bits */
+static inline uint64_t Rng_next(Rng* g) {
+    uint64_t* s = g->s;
+    uint64_t result = Rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = Rng_rotl(s[3], 45);
+    return result;
+}
+
+/**
+ * @return a number in [0, n), by Lemire's multiply-and-shift instead of a
+ * division. Its bias is at most n / 2^64, far below anything a simulation
+ * can see.
+ */
+static inline unsigned long Rng_below(Rng* g, unsigned long n) {
+    __extension__ typedef unsigned __int128 u128;
+    return (unsigned long)(((u128)Rng_next(g) * n) >> 64);
+}
+
+#endif
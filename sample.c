@@ -0,0 +1,146 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file sample.c
+ * @brief Spatially sampled simulation, see sample.h.
+ */
+#define _GNU_SOURCE
+
+#include "sample.h"
+#include <assert.h>
+#include <math.h>
+#include <search.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Sets the threshold, adjusted so that memory scales by exactly the sampling
+ * rate. The scaled memory is rounded down to whole frames, one at least, and
+ * the rate follows it.
+ */
+static void Sample_setThreshold(Sample* s, uint64_t threshold, int frames) {
+    long scaled = (long)((double)frames * threshold / SAMPLE_MODULUS);
+    if (scaled < 1) scaled = 1;
+    if (scaled >= frames || threshold >= SAMPLE_MODULUS) {
+        s->frames = frames;
+        s->threshold = SAMPLE_MODULUS;
+    } else {
+        s->frames = scaled;
+        s->threshold = (uint64_t)scaled * SAMPLE_MODULUS / frames;
+    }
+    s->rate = (double)s->threshold / SAMPLE_MODULUS;
+}
+
+void Sample_initRate(Sample* s, double rate, int frames) {
+    assert(rate > 0 && rate <= 1);
+    Sample_setThreshold(s, (uint64_t)(rate * SAMPLE_MODULUS), frames);
+}
+
+// === FIXED SIZE ===
+
+// tsearch keys are sampling values + 1, stored in the pointer itself
+static int Sample_compareValue(const void* l, const void* r) {
+    return ((uintptr_t)l > (uintptr_t)r) - ((uintptr_t)l < (uintptr_t)r);
+}
+
+static void Sample_noFree(__attribute__((unused)) void* node) {}
+
+/** Restores the max-heap property below index i */
+static void Sample_siftDown(uint32_t* heap, size_t n, size_t i) {
+    while (2 * i + 1 < n) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < n && heap[child + 1] > heap[child]) child++;
+        if (heap[i] >= heap[child]) return;
+        uint32_t tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/** Restores the max-heap property above index i */
+static void Sample_siftUp(uint32_t* heap, size_t i) {
+    while (i > 0 && heap[(i - 1) / 2] < heap[i]) {
+        uint32_t tmp = heap[i];
+        heap[i] = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = tmp;
+        i = (i - 1) / 2;
+    }
+}
+
+void Sample_initSize(Sample* s, Trace* trace, size_t pages, int frames) {
+    assert(pages > 0);
+
+    // the lowest distinct sampling values seen so far: a max-heap to find the
+    // one to drop, and a tree to skip values already in the heap
+    uint32_t* heap = malloc(pages * sizeof(uint32_t));
+    if (heap == NULL) {
+        perror("Error allocating memory for sample set.");
+        exit(EXIT_FAILURE);
+    }
+    size_t size = 0;
+    void* tree = NULL;
+
+    unsigned long pid;
+    unsigned long vpn;
+    Trace_adviseSequential(trace, true);
+    Trace_rewind(trace);
+    while (Trace_next(trace, &pid, &vpn)) {
+        uint32_t value = Sample_hash(pid, vpn) & (SAMPLE_MODULUS - 1);
+        if (size == pages && value >= heap[0]) continue; // the common case
+
+        void* key = (void*)((uintptr_t)value + 1);
+        if (tfind(key, &tree, Sample_compareValue) != NULL) continue;
+        if (size == pages) {
+            tdelete((void*)((uintptr_t)heap[0] + 1), &tree,
+                    Sample_compareValue);
+            heap[0] = value;
+            Sample_siftDown(heap, size, 0);
+        } else {
+            heap[size] = value;
+            Sample_siftUp(heap, size++);
+        }
+        if (tsearch(key, &tree, Sample_compareValue) == NULL) {
+            perror("Error searching for sampled value.");
+            exit(EXIT_FAILURE);
+        }
+    }
+    Trace_rewind(trace);
+
+    uint64_t threshold = size == pages ? (uint64_t)heap[0] + 1 : SAMPLE_MODULUS;
+    Sample_setThreshold(s, threshold, frames);
+    tdestroy(tree, Sample_noFree);
+    free(heap);
+}
+
+// === RESULTS ===
+
+StatSummary Sample_scale(const Sample* s, StatSummary r) {
+    // utilization and runnable processes are averages, and scale by 1
+    r.tmr = (unsigned long)(r.tmr / s->rate + 0.5);
+    r.tpi = (unsigned long)(r.tpi / s->rate + 0.5);
+    r.time = (unsigned long)(r.time / s->rate + 0.5);
+    return r;
+}
+
+void Sample_printStats(const Sample* s, const char* const* names,
+                       const unsigned long* const* groupFaults, size_t n) {
+    printf("\x1B[1m\x1B[7m%s\x1B[0m\n", " SAMPLING ");
+    printf("  rate: %f\n", s->rate);
+    printf("  simulated memory: %i pages\n", s->frames);
+    for (size_t i = 0; i < n; i++) {
+        // each group is a sample at rate / SAMPLE_GROUPS of its own; the
+        // spread of their estimates gives the standard error of the mean
+        unsigned long faults = 0;
+        for (int g = 0; g < SAMPLE_GROUPS; g++) faults += groupFaults[i][g];
+        double mean = faults / s->rate;
+        double var = 0;
+        for (int g = 0; g < SAMPLE_GROUPS; g++) {
+            double estimate = SAMPLE_GROUPS * groupFaults[i][g] / s->rate;
+            var += (estimate - mean) * (estimate - mean);
+        }
+        var /= SAMPLE_GROUPS - 1;
+        double error = s->rate < 1 ? sqrt(var / SAMPLE_GROUPS) : 0;
+        printf("  \x1B[96m%s TPI:\x1B[0m %.0f +/- %.0f (%.2f%%, std. error)\n",
+               names[i], mean, error, mean > 0 ? 100 * error / mean : 0.0);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file sample.h
+ * @brief Spatially sampled simulation (-s, -S), after SHARDS: each page
+ * <pid, vpn> is hashed, and only references to pages whose hash falls under
+ * a threshold are simulated, with memory scaled down by the same rate R.
+ * @details A page is either always or never sampled, so the sampled trace
+ * looks like the full one with fewer pages, and any replacement policy sees
+ * a scaled down version of the same workload. Counts are scaled back up by
+ * 1/R. The error of the fault count is estimated by splitting the sample
+ * into SAMPLE_GROUPS groups by other bits of the same hash, each a sample at
+ * rate R/SAMPLE_GROUPS, and taking the spread of their estimates.
+ */
+
+#ifndef _SAMPLE_
+#define _SAMPLE_
+
+#include "stat.h"
+#include "trace_reader.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+enum {
+    SAMPLE_GROUPS = 16, // for the error estimate
+};
+
+// sampling values are the low 32 bits of the hash
+#define SAMPLE_MODULUS ((uint64_t)1 << 32)
+
+typedef struct sample_t {
+    uint64_t threshold; // pages with a sampling value below this are kept
+    double rate;        // threshold / SAMPLE_MODULUS
+    int frames;         // memory of the sampled simulation, in pages
+} Sample;
+
+/** Mixes a page's identity into 64 well distributed bits */
+static inline uint64_t Sample_hash(unsigned long pid, unsigned long vpn) {
+    uint64_t h = vpn * 0x9E3779B97F4A7C15ULL + pid;
+    // MurmurHash3's 64-bit finalizer
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/** @return true if references to this page are simulated */
+static inline bool Sample_keep(const Sample* s, unsigned long pid,
+                               unsigned long vpn) {
+    return (Sample_hash(pid, vpn) & (SAMPLE_MODULUS - 1)) < s->threshold;
+}
+
+/** @return the error estimation group of a page */
+static inline int Sample_group(unsigned long pid, unsigned long vpn) {
+    return (Sample_hash(pid, vpn) >> 32) % SAMPLE_GROUPS;
+}
+
+/**
+ * Sets up sampling at a fixed rate.
+ * @param rate fraction of pages to keep, in (0, 1]
+ * @param frames memory of the full simulation, in pages
+ */
+void Sample_initRate(Sample* s, double rate, int frames);
+
+/**
+ * Sets up sampling of at most a given number of pages, so memory use is
+ * bounded whatever the trace. Scans the trace once to find the threshold,
+ * keeping only the lowest sampling values seen.
+ * @param trace trace opened with Trace_open; read from the start
+ * @param pages most pages to keep
+ * @param frames memory of the full simulation, in pages
+ */
+void Sample_initSize(Sample* s, Trace* trace, size_t pages, int frames);
+
+/** Scales a sampled run's results up to estimates for the full trace */
+StatSummary Sample_scale(const Sample* s, StatSummary r);
+
+/**
+ * Prints the sampling parameters and the estimated error of each run's
+ * fault count.
+ * @param names one per run
+ * @param groupFaults faults of each run, SAMPLE_GROUPS counts split by
+ * Sample_group
+ * @param n number of runs
+ */
+void Sample_printStats(const Sample* s, const char* const* names,
+                       const unsigned long* const* groupFaults, size_t n);
+
+#endif
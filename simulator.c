@@ -7,9 +7,9 @@
 
 #include "simulator.h"
 #include "intervaltree.h"
-#include "replace.h"
-#include "stat.h"
 #include <assert.h>
+#include <limits.h>
+#include <string.h>
 
 // === SIMULATION PARAMETERS ===
 enum {
@@ -26,76 +26,105 @@ static_assert(DISK_PENALTY % CLOCK_TICK == 0,
 // === HELPER FUNCTIONS ===
 
 /** @return true when all processes are finished */
-static inline bool Simulator_notDone() {
-    return Process_existsWithStatus(RUNNABLE)
-           || Process_existsWithStatus(BLOCKED);
+static inline bool Simulator_notDone(Simulator* sim) {
+    return Process_existsWithStatus(&sim->queues, RUNNABLE)
+           || Process_existsWithStatus(&sim->queues, BLOCKED);
 }
 
-/** ftell wrapper, returns current line on success or errors with message */
-static inline long safe_ftell(FILE* tracefile) {
-    long fpos = ftell(tracefile);
-    if (fpos == -1) {
-        perror("Error finding current line in trace file.");
-        exit(EXIT_FAILURE);
-    }
-    return fpos;
+/** Return to the trace position saved in a given process, if reading from
+ * the trace */
+static inline void Simulator_seekSavedLine(Trace* trace, Process* p) {
+    assert(p != NULL && p->status != FINISHED);
+    if (trace != NULL) Trace_seek(trace, p->currentPos);
 }
 
-/** Return to the file position saved in a given process */
-static inline void Simulator_seekSavedLine(FILE* tracefile, Process* p) {
-    assert(p != NULL && p->status != FINISHED);
+/**
+ * Fetches the VPN on the current line of a process, from its RefColumn in
+ * columnar mode or else from the trace, which must already be positioned there
+ * @param trace open trace, or NULL in columnar mode
+ * @param p running process
+ * @param[out] fpos trace position of the line, if reading from the trace
+ * @return vpn
+ */
+static inline unsigned long Simulator_readLine(Trace* trace, const Process* p,
+                                               long* fpos) {
+    if (trace == NULL) {
+        assert(p->nextRef < p->refs.length && "column shorter than intervals");
+        *fpos = 0;
+        return p->refs.vpns[p->nextRef];
+    }
 
-    if (fseek(tracefile, p->currentPos, SEEK_SET) != 0
-        || safe_ftell(tracefile) != p->currentPos) {
-        perror("Seek to position within tracefile failed.");
+    unsigned long pid;
+    unsigned long vpn;
+    *fpos = Trace_tell(trace);
+    if (!Trace_next(trace, &pid, &vpn)) {
+        fprintf(stderr, "ERROR: Reached end of trace file early.\n");
         exit(EXIT_FAILURE);
     }
+
+    if (pid != p->pid) {
+        fprintf(stderr, "ERROR: Wrong line in tracefile recieved.\n");
+    }
+    return vpn;
 }
 
 /** Load the next blocked page, evicting if neccesary
  * @details notifies replacement module of page load
  */
-static inline void Simulator_finishCurrentDiskIO() {
-    Process* p = Process_peek(BLOCKED);
+static inline void Simulator_finishCurrentDiskIO(Simulator* sim) {
+    Process* p = Process_peek(&sim->queues, BLOCKED);
     assert(p != NULL && p->status == BLOCKED);
     assert(p->waitTime == 0 && "Page can't load until after process waits");
     assert(p->waitingOnPage != NULL && "no page to fetch");
 
     unsigned long ppn;
 
-    if (Memory_hasFreePage()) {
-        ppn = Memory_getFreePage();
-        Memory_loadPage(p->waitingOnPage, ppn);
-        Replace_notifyPageLoad(p->waitingOnPage->overhead);
+    if (p->refs.nextUse != NULL) {
+        Replace_notifyNextUse(&sim->replace, p->waitingOnPage,
+                              p->refs.nextUse[p->nextRef]);
+    }
+    Replace_notifyPageFault(&sim->replace, p->waitingOnPage);
+    if (Memory_hasFreePage(&sim->memory)) {
+        ppn = Memory_getFreePage(&sim->memory);
     } else {
-        ppn = Replace_getPageToEvict();
-        Memory_evictPage(ppn);
-        Memory_loadPage(p->waitingOnPage, ppn);
-        Replace_notifyPageLoad(p->waitingOnPage->overhead);
+        ppn = Replace_getPageToEvict(&sim->replace);
+        Replace_notifyPageEvict(&sim->replace,
+                                Memory_getVPage(&sim->memory, ppn));
+        Memory_evictPage(&sim->memory, ppn);
     }
+    Memory_loadPage(&sim->memory, p->waitingOnPage, ppn);
+    Replace_notifyPageLoad(&sim->replace, p->waitingOnPage);
 
+    p->loadedPage = p->waitingOnPage;
     p->waitingOnPage = NULL;
 }
 
+/** Page table walker that takes a finished process's pages out of memory */
+static void Simulator_releasePage(VPage* v, void* arg) {
+    Simulator* sim = arg;
+    if (v->inMemory) {
+        Replace_notifyPageEvict(&sim->replace, v);
+        Memory_evictPage(&sim->memory, v->currentPPN);
+    }
+}
+
 /**
  * Wrapper that handles special cases of status/context switches. Use only this
  * function to perform context switches in the simulator.
- * @param tracefile currently open file
  * @param p process to switch
  * @param new new status for process
- * @param fpos
+ * @param fpos trace position to resume from, if p was running
  */
-static inline void Simulator_safelySwitchStatus(FILE* tracefile, Process* p,
+static inline void Simulator_safelySwitchStatus(Simulator* sim, Process* p,
                                                 ProcessStatus new, long fpos) {
-    assert(tracefile != NULL && ferror(tracefile) == 0);
     assert(p != NULL);
 
     ProcessStatus old = p->status;
-    assert(Process_peek(old) == p && "not at head of queue");
+    assert(Process_peek(&sim->queues, old) == p && "not at head of queue");
 
     if (old == RUNNABLE) {
-        assert(tracefile != NULL && Process_peek(RUNNABLE) != NULL);
-        Process_peek(RUNNABLE)->currentPos = fpos;
+        assert(Process_peek(&sim->queues, RUNNABLE) != NULL);
+        Process_peek(&sim->queues, RUNNABLE)->currentPos = fpos;
 
     } else if (old == BLOCKED) {
         assert(p->waitTime == 0
@@ -106,7 +135,7 @@ static inline void Simulator_safelySwitchStatus(FILE* tracefile, Process* p,
         exit(EXIT_FAILURE);
     }
 
-    if (Process_switchStatus(old, new) != p) {
+    if (Process_switchStatus(&sim->queues, old, new) != p) {
         fprintf(stderr,
                 "ERROR: Corruption in process queue. Do not modify data "
                 "structures concurrently with execution.");
@@ -114,13 +143,18 @@ static inline void Simulator_safelySwitchStatus(FILE* tracefile, Process* p,
     }
 
     if (new == RUNNABLE) {
-        Simulator_seekSavedLine(tracefile, p);
+        Simulator_seekSavedLine(sim->trace, p);
     } else if (new == BLOCKED) {
         assert(p->waitTime == DISK_PENALTY
                && "Set block timer in order to block process.");
     } else if (new == FINISHED) {
         assert(!Process_hasLinesRemainingInFile(p)
                && "Cannot mark process as finished with lines left to run.");
+        Stat_pageTable(&sim->stats, p->pid, p->pageTable->count,
+                       PageTable_bytes(p->pageTable));
+        Stat_process(&sim->stats, p->pid, p->frames.virtualTime, p->faults,
+                     sim->time);
+        PageTable_forEach(p->pageTable, Simulator_releasePage, sim);
         Process_quit(p); // clean up and free memory
     }
 }
@@ -128,113 +162,230 @@ static inline void Simulator_safelySwitchStatus(FILE* tracefile, Process* p,
 // === SIMULATION ===
 
 /**
- * Runs the simulation.
- * @param pointer to tracefile, opened in read mode
+ * Charges Stat_default for all time since the last call, using the memory and
+ * queue state that has held since then. Call before anything that changes
+ * the number of allocated pages or whether a process is runnable.
  */
-unsigned long Simulator_runSimulation(FILE* tracefile) {
-    unsigned long time = 0; // time in nanoseconds
+static inline void Simulator_accountUpTo(Simulator* sim, unsigned long time) {
+    if (time > sim->accounted) {
+        Stat_default(&sim->stats, time - sim->accounted);
+        sim->accounted = time;
+    }
+}
 
-    assert(tracefile != NULL && "tracefile can't be null");
-    rewind(tracefile); // reset ptr
-    Process* p = Process_peek(RUNNABLE);
+/**
+ * Runs one line of the process at the head of the RUNNABLE queue, at the
+ * current time.
+ * @details on a hit the process advances (to its next line or interval, or
+ * finishes); on a miss it blocks for DISK_PENALTY behind any queued I/O
+ * @return true if the line missed and the process blocked
+ */
+static inline bool Simulator_runLine(Simulator* sim) {
+    Process* p = Process_peek(&sim->queues, RUNNABLE);
+    assert(p != NULL);
+    assert(p->currInterval != NULL);
+
+    // upon context switch, jump to the new file position
+    if (p != sim->current) {
+        sim->current = p;
+        if (sim->trace != NULL && p->currentPos != Trace_tell(sim->trace)) {
+            Simulator_seekSavedLine(sim->trace, p);
+        }
+    }
+
+    // Find line to run next
+    long fpos;
+    unsigned long vpn = Simulator_readLine(sim->trace, p, &fpos);
+
+    // Simulate memory reference
+    // look up the virtual page in this proc.'s page table, creating it on
+    // first reference; the same probe says whether it's a hit or a miss
+    bool inMemory;
+    VPage* v = Process_referenceVirtualPage(p, vpn, &inMemory);
+    assert(v != NULL);
+
+    if (inMemory) {
+        Stat_hit(&sim->stats);
+        if (p->refs.nextUse != NULL) {
+            Replace_notifyNextUse(&sim->replace, v,
+                                  p->refs.nextUse[p->nextRef]);
+        }
+        if (v == p->loadedPage) {
+            Replace_notifyPageRetry(&sim->replace, v);
+        } else {
+            Replace_notifyPageAccess(&sim->replace, v);
+        }
+        p->loadedPage = NULL;
+        p->nextRef++;
+        p->frames.virtualTime++;
+
+        if (Process_onLastLineInInterval(p)
+            && Process_hasIntervalsRemaining(p)) {
+
+            // advance file pointer
+            Process_jumpToNextInterval(p);
+            Simulator_seekSavedLine(sim->trace, p);
+
+            // context switch
+            Process_switchStatus(&sim->queues, RUNNABLE, RUNNABLE); // does not check for
+                                                      // safety, but fast
+        } else if (Process_hasLinesRemainingInInterval(p)) {
+            p->currentline++;
+        } else {
+            // no remaining intervals, no remaining lines -> finished
+            Simulator_accountUpTo(sim, sim->time);
+            Simulator_safelySwitchStatus(sim, p, FINISHED, 0);
+            sim->current = NULL;
+        }
+        return false;
+    } else {
+        Simulator_accountUpTo(sim, sim->time);
+        Stat_miss(&sim->stats);
+        p->faults++;
+        if (sim->sample != NULL) {
+            sim->sampleFaults[Sample_group(p->pid, vpn)]++;
+        }
+        p->waitTime = DISK_PENALTY;
+        p->waitingOnPage = v;
 
-    while (Simulator_notDone()) {
+        // the disk serves one request at a time, in order
+        p->wakeTime = (sim->diskFreeAt > sim->time ? sim->diskFreeAt
+                                                   : sim->time)
+                      + DISK_PENALTY;
+        sim->diskFreeAt = p->wakeTime;
+
+        Simulator_safelySwitchStatus(sim, p, BLOCKED, fpos);
+        return true;
+    }
+}
+
+/** Completes the disk I/O at the head of the BLOCKED queue and makes its
+ * process runnable again */
+static inline void Simulator_wakeBlocked(Simulator* sim) {
+    Simulator_finishCurrentDiskIO(sim); // evicts if needed
+
+    // switching to RUNNABLE seeks the trace to this process's line, so
+    // whoever runs next has to seek back unless it's this process
+    sim->current = Process_peek(&sim->queues, BLOCKED);
+    Simulator_safelySwitchStatus(sim, sim->current, RUNNABLE, 0);
+}
+
+/**
+ * Reference engine: advances time one CLOCK_TICK per iteration, counting down
+ * the head BLOCKED process's wait every tick. Kept to validate the event
+ * engine against.
+ */
+static void Simulator_runTicks(Simulator* sim) {
+    while (Simulator_notDone(sim)) {
         // 0. Account for clock tick
-        time += CLOCK_TICK;
-        Stat_default(CLOCK_TICK);
+        sim->time += CLOCK_TICK;
+        Simulator_accountUpTo(sim, sim->time);
 
         // 1. Advance disk wait counter if needed
-        if (Process_existsWithStatus(BLOCKED)) {
-            Process_peek(BLOCKED)->waitTime -= CLOCK_TICK;
-            if (Process_peek(BLOCKED)->waitTime == 0) {
-                Simulator_finishCurrentDiskIO(); // evicts if needed
-                Simulator_safelySwitchStatus(tracefile, Process_peek(BLOCKED),
-                                             RUNNABLE, 0);
+        if (Process_existsWithStatus(&sim->queues, BLOCKED)) {
+            Process_peek(&sim->queues, BLOCKED)->waitTime -= CLOCK_TICK;
+            if (Process_peek(&sim->queues, BLOCKED)->waitTime == 0) {
+                Simulator_wakeBlocked(sim);
                 continue;
             }
         }
 
         // 2. If all processes are blocked, jump to the time where one finishes
         // waiting
-        if (!Process_existsWithStatus(RUNNABLE)) {
-            assert((Process_peek(BLOCKED))->waitTime != 0);
+        if (!Process_existsWithStatus(&sim->queues, RUNNABLE)) {
+            assert((Process_peek(&sim->queues, BLOCKED))->waitTime != 0);
             unsigned long skip =
-              CLOCK_TICK * ((Process_peek(BLOCKED))->waitTime - 1);
-            time += skip;
-            Stat_default(skip);
-            Process_peek(BLOCKED)->waitTime -= skip;
-            assert((Process_peek(BLOCKED))->waitTime == 1);
+              CLOCK_TICK * ((Process_peek(&sim->queues, BLOCKED))->waitTime - 1);
+            sim->time += skip;
+            Simulator_accountUpTo(sim, sim->time);
+            Process_peek(&sim->queues, BLOCKED)->waitTime -= skip;
+            assert((Process_peek(&sim->queues, BLOCKED))->waitTime == 1);
             continue;
         }
 
-        // upon context switch, jump to the new file position
-        if (p != Process_peek(RUNNABLE)) {
-            p = Process_peek(RUNNABLE);
-            if (p->currentPos != ftell(tracefile)) {
-                Simulator_seekSavedLine(tracefile, p);
+        // 3. Run a line
+        Simulator_runLine(sim);
+    }
+}
+
+/**
+ * Discrete-event engine: jumps straight from event to event.
+ * @details There are two kinds of events. An I/O completion is due at the
+ * wakeTime of a BLOCKED process; since the disk serves requests first come
+ * first served, the BLOCKED queue is already the time-ordered queue of
+ * pending completions, and only its head can be next. A run is the RUNNABLE
+ * head executing one line per CLOCK_TICK, which continues uninterrupted until
+ * the tick before the next completion (completions win ties, as in the tick
+ * engine). Nothing stat-related changes within a run except at misses and
+ * process exits, so Stat_default is charged in bulk at those points instead
+ * of every tick. Produces exactly the tick engine's results.
+ */
+static void Simulator_runEvents(Simulator* sim) {
+    while (Simulator_notDone(sim)) {
+        unsigned long nextIO = Process_existsWithStatus(&sim->queues, BLOCKED)
+                                 ? Process_peek(&sim->queues, BLOCKED)->wakeTime
+                                 : ULONG_MAX;
+
+        // run lines until the disk interrupts or nothing is runnable
+        while (Process_existsWithStatus(&sim->queues, RUNNABLE)
+               && sim->time + CLOCK_TICK < nextIO) {
+            sim->time += CLOCK_TICK;
+            if (Simulator_runLine(sim) && nextIO == ULONG_MAX) {
+                nextIO = Process_peek(&sim->queues, BLOCKED)->wakeTime; // disk was idle
             }
         }
 
-        // 3. Find line to run next
-        unsigned long pid;
-        unsigned long vpn;
-        assert(p != NULL);
-        assert(p->currInterval != NULL);
+        if (nextIO == ULONG_MAX) break; // everything finished
 
-        long fpos = ftell(tracefile);
-        if (fpos == -1) {
-            perror("Error finding current line in trace file.");
-            exit(EXIT_FAILURE);
-        }
-        if (fscanf(tracefile, "%lu %lu\n", &pid, &vpn) != 2) {
-            perror("Error reading from trace file.");
-            exit(EXIT_FAILURE);
-        }
+        // next event is the I/O completion, idling until then if needed
+        sim->time = nextIO;
+        Simulator_accountUpTo(sim, sim->time);
+        Process_peek(&sim->queues, BLOCKED)->waitTime = 0;
+        Simulator_wakeBlocked(sim);
+    }
+}
 
-        if (pid != p->pid) {
-            fprintf(stderr, "ERROR: Wrong line in tracefile recieved.\n");
-        }
+void Simulator_init(Simulator* sim, const ReplaceSpec* spec,
+                    int numberOfPhysicalPages) {
+    Memory_init(&sim->memory, numberOfPhysicalPages);
+    Replace_init(&sim->replace, spec, &sim->memory);
+    ProcessQueues_init(&sim->queues);
+    Stat_init(&sim->stats, &sim->memory, &sim->queues);
+    sim->trace = NULL;
+    sim->time = 0;
+    sim->accounted = 0;
+    sim->diskFreeAt = 0;
+    sim->current = NULL;
+    sim->sample = NULL;
+    memset(sim->sampleFaults, 0, sizeof(sim->sampleFaults));
+}
 
-        // 4. Simulate memory reference
-        // get the virtual page-> look up in page table for this proc.
-        VPage* v = Process_getVirtualPage(p, vpn);
+unsigned long Simulator_runSimulation(Simulator* sim, Trace* trace,
+                                      SimulatorEngine engine) {
+    sim->trace = trace;
+    sim->time = 0;
+    sim->accounted = 0;
+    sim->diskFreeAt = 0;
 
-        // Create new v. page if none exists
-        if (v == NULL) {
-            v = Process_allocVirtualPage(p, vpn);
-            assert(v != NULL);
-            assert(Process_getVirtualPage(p, vpn) == v);
-        }
+    if (trace != NULL) {
+        Trace_adviseSequential(trace, false); // processes jump around the trace
+        Trace_rewind(trace); // reset ptr
+    }
+    sim->current = Process_peek(&sim->queues, RUNNABLE);
 
-        // Is it a hit or a miss?
-        if (Process_virtualPageInMemory(p, vpn)) {
-            Stat_hit();
-            Replace_notifyPageAccess(v->overhead);
-
-            if (Process_onLastLineInInterval(p)
-                && Process_hasIntervalsRemaining(p)) {
-
-                // advance file pointer
-                Process_jumpToNextInterval(p);
-                Simulator_seekSavedLine(tracefile, p);
-
-                // context switch
-                Process_switchStatus(RUNNABLE, RUNNABLE); // does not check for
-                                                          // safety, but fast
-            } else if (Process_hasLinesRemainingInInterval(p)) {
-                p->currentline++;
-            } else {
-                // no remaining intervals, no remaining lines -> finished
-                Simulator_safelySwitchStatus(tracefile, p, FINISHED, 0);
-                p = NULL;
-            }
-        } else {
-            Stat_miss();
-            p->waitTime = DISK_PENALTY;
-            p->waitingOnPage = v;
-            Simulator_safelySwitchStatus(tracefile, p, BLOCKED, fpos);
-        }
+    if (engine == ENGINE_TICK) {
+        Simulator_runTicks(sim);
+    } else {
+        Simulator_runEvents(sim);
     }
 
-    return time;
+    sim->trace = NULL;
+    return sim->time;
+}
+
+void Simulator_free(Simulator* sim) {
+    ProcessQueues_free(&sim->queues);
+    Stat_free(&sim->stats);
+    Replace_free(&sim->replace);
+    Memory_free(&sim->memory);
 }
@@ -5,8 +5,65 @@
  * @author Michael Noguera
  */
 
+#ifndef _SIMULATOR_
+#define _SIMULATOR_
+
 #include "intervaltree.h"
+#include "memory.h"
 #include "process.h"
+#include "replace.h"
+#include "sample.h"
+#include "stat.h"
 #include "trace_parser.h"
+#include "trace_reader.h"
+
+typedef enum SimulatorEngine {
+    ENGINE_EVENT = 0, // jump from event to event (default)
+    ENGINE_TICK = 1,  // advance one clock tick at a time, for validation
+} SimulatorEngine;
+
+// One simulation: a memory, the processes running on it and the policy
+// managing it. Simulators share nothing, so several can run side by side on
+// clones of the same processes (see ProcessQueues_clone).
+typedef struct simulator_t {
+    Memory memory;
+    ProcessQueues queues;
+    Replace replace;
+    Stats stats;
+
+    // state of a run, shared by both engines
+    Trace* trace;            // NULL in columnar mode
+    unsigned long time;      // current time in nanoseconds
+    unsigned long accounted; // Stat_default has been charged up to this time
+    unsigned long diskFreeAt; // time the last queued disk I/O completes
+    Process* current; // process the trace is positioned for, if any
+
+    // sampled simulation only (-s, -S)
+    const Sample* sample; // NULL if every page is simulated
+    unsigned long sampleFaults[SAMPLE_GROUPS]; // faults by Sample_group
+} Simulator;
+
+/**
+ * Sets up a simulator with empty process queues, for first_pass or
+ * ProcessQueues_clone to fill.
+ * @param spec replacement policy and its parameter
+ * @param numberOfPhysicalPages size of memory in pages
+ */
+void Simulator_init(Simulator* sim, const ReplaceSpec* spec,
+                    int numberOfPhysicalPages);
+
+/**
+ * Runs the simulation.
+ * @param trace trace opened with Trace_open, after the first pass, or NULL to
+ * take references from each process's RefColumn (columnar mode). Only one
+ * simulator may read a given Trace at a time.
+ * @param engine how to advance time; both give identical results
+ * @return time the last process finished, in nanoseconds
+ */
+unsigned long Simulator_runSimulation(Simulator* sim, Trace* trace,
+                                      SimulatorEngine engine);
+
+/** Frees everything a simulator holds */
+void Simulator_free(Simulator* sim);
 
-unsigned long Simulator_runSimulation(FILE* tracefile);
+#endif
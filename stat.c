@@ -9,55 +9,190 @@
 #include "memory.h"
 #include "process.h"
 
+#include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-static struct stat_t* ProgStats;
+// Initialize stat structure, for a simulation using this memory and queues
+void Stat_init(Stats* s, Memory* memory, ProcessQueues* queues) {
+    s->tmu = 0;
+    s->trp = 0;
+    s->tmr = 0;
+    s->tpi = 0;
+    s->memory = memory;
+    s->queues = queues;
+    s->ptStats = NULL;
+    s->ptStatsLength = 0;
+    s->ptStatsCapacity = 0;
+    s->procStats = NULL;
+    s->procStatsLength = 0;
+    s->procStatsCapacity = 0;
+}
 
-// Initialize stat structure
-void Stat_init() {
-    ProgStats = (struct stat_t*)malloc(sizeof(struct stat_t));
-    if ((ProgStats) == NULL) {
-        perror("Error allocating memory for stats data structure.");
-        exit(EXIT_FAILURE);
-    }
-    ProgStats->tmu = 0;
-    ProgStats->trp = 0;
-    ProgStats->tmr = 0;
-    ProgStats->tpi = 0;
+// Free stat structure
+void Stat_free(Stats* s) {
+    free(s->ptStats);
+    s->ptStats = NULL;
+    s->ptStatsLength = s->ptStatsCapacity = 0;
+    free(s->procStats);
+    s->procStats = NULL;
+    s->procStatsLength = s->procStatsCapacity = 0;
 }
 
 // No matter what happens this tick, this will still be called and still applies.
-void Stat_default(unsigned long numTicks) {
-    ProgStats->tmu += Memory_howManyAllocPages() * numTicks;
+void Stat_default(Stats* s, unsigned long numTicks) {
+    s->tmu += Memory_howManyAllocPages(s->memory) * numTicks;
     // ONLY ONE PROCESS CAN BE IN THE 'RUNNING' QUEUE AT A TIME!
-    ProgStats->trp += (((int)Process_existsWithStatus(RUNNABLE))) * numTicks;
+    s->trp += (((int)Process_existsWithStatus(s->queues, RUNNABLE))) * numTicks;
 }
 
 // This tick, a hit happened
-void Stat_hit() {
-    ProgStats->tmr += 1;
+void Stat_hit(Stats* s) {
+    s->tmr += 1;
 }
 
 // This tick, a miss happened
-void Stat_miss() {
-    ProgStats->tpi += 1;
+void Stat_miss(Stats* s) {
+    s->tpi += 1;
+}
+
+// Compute the final results, given an end time for the program.
+StatSummary Stat_summarize(const Stats* s, unsigned long time) {
+    float amu = s->tmu / (float)time;
+    float arp = s->trp / (float)time;
+    return (StatSummary){amu / Memory_getTotalSize(s->memory), arp, s->tmr,
+                         s->tpi, time};
 }
 
 // Print the stats out directly, given an end time for the program.
-void Stat_printStats(unsigned long time) {
-    float amu = ProgStats->tmu / (float)time;
-    float arp = ProgStats->trp / (float)time;
-    //printf("(tmu=%lu)\n", ProgStats->tmu);
+void Stat_printStats(const Stats* s, unsigned long time) {
+    StatSummary r = Stat_summarize(s, time);
+    //printf("(tmu=%lu)\n", s->tmu);
+    Stat_printSummary(&r);
+}
+
+// Print results that have already been summarized
+void Stat_printSummary(const StatSummary* r) {
+    printf("\x1B[1m\x1B[7m%s\x1B[0m\n"," PERFORMANCE ");
+    printf("  \x1B[91mAMU:  \x1B[0m %f\n", r->amu);
+    printf("  \x1B[33mARP:  \x1B[0m %f\n", r->arp);
+    printf("  \x1B[92mTMR:  \x1B[0m %lu\n", r->tmr);
+    printf("  \x1B[96mTPI:  \x1B[0m %lu\n", r->tpi);
+    printf("  \x1B[95mRTime:\x1B[0m %lu\n", r->time);
+}
 
+// Print several runs' results next to each other, one column per name
+void Stat_printTable(const char* const* names, const StatSummary* results,
+                     size_t n) {
     printf("\x1B[1m\x1B[7m%s\x1B[0m\n"," PERFORMANCE ");
-    printf("  \x1B[91mAMU:  \x1B[0m %f\n", amu/Memory_getTotalSize());
-    printf("  \x1B[33mARP:  \x1B[0m %f\n", arp);
-    printf("  \x1B[92mTMR:  \x1B[0m %lu\n", ProgStats->tmr);
-    printf("  \x1B[96mTPI:  \x1B[0m %lu\n", ProgStats->tpi);
-    printf("  \x1B[95mRTime:\x1B[0m %lu\n", time);
+    printf("        ");
+    for (size_t i = 0; i < n; i++) printf(" %16s", names[i]);
+    printf("\n  \x1B[91mAMU:  \x1B[0m");
+    for (size_t i = 0; i < n; i++) printf(" %16f", results[i].amu);
+    printf("\n  \x1B[33mARP:  \x1B[0m");
+    for (size_t i = 0; i < n; i++) printf(" %16f", results[i].arp);
+    printf("\n  \x1B[92mTMR:  \x1B[0m");
+    for (size_t i = 0; i < n; i++) printf(" %16lu", results[i].tmr);
+    printf("\n  \x1B[96mTPI:  \x1B[0m");
+    for (size_t i = 0; i < n; i++) printf(" %16lu", results[i].tpi);
+    printf("\n  \x1B[95mRTime:\x1B[0m");
+    for (size_t i = 0; i < n; i++) printf(" %16lu", results[i].time);
+    printf("\n");
+}
+
+unsigned long Stat_tmr_so_far(const Stats* s) {
+    return s->tmr;
 }
 
-unsigned long Stat_tmr_so_far() {
-    return ProgStats->tmr;
+// A process finished with a page table of this size
+void Stat_pageTable(Stats* s, unsigned long pid, size_t pages, size_t bytes) {
+    if (s->ptStatsLength == s->ptStatsCapacity) {
+        s->ptStatsCapacity = s->ptStatsCapacity ? s->ptStatsCapacity * 2 : 16;
+        s->ptStats =
+          realloc(s->ptStats, s->ptStatsCapacity * sizeof(*s->ptStats));
+        if (s->ptStats == NULL) {
+            perror("Error allocating memory for page table stats.");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s->ptStats[s->ptStatsLength++] = (struct pt_stat_t){pid, pages, bytes};
+}
+
+static int Stat_comparePid(const void* a, const void* b) {
+    unsigned long pa = ((const struct pt_stat_t*)a)->pid;
+    unsigned long pb = ((const struct pt_stat_t*)b)->pid;
+    return (pa > pb) - (pa < pb);
+}
+
+// Print every finished process's page table size, by pid, and the totals
+void Stat_printPageTables(Stats* s) {
+    struct pt_stat_t* ptStats = s->ptStats;
+    size_t ptStatsLength = s->ptStatsLength;
+    qsort(ptStats, ptStatsLength, sizeof(*ptStats), Stat_comparePid);
+
+    size_t pages = 0;
+    size_t bytes = 0;
+    printf("\x1B[1m\x1B[7m%s\x1B[0m\n", " PAGE TABLES ");
+    for (size_t i = 0; i < ptStatsLength; i++) {
+        printf("  pid %lu: %zu pages, %zu B (%.1f B/page)\n", ptStats[i].pid,
+               ptStats[i].pages, ptStats[i].bytes,
+               ptStats[i].pages ? ptStats[i].bytes / (double)ptStats[i].pages
+                                : 0.0);
+        pages += ptStats[i].pages;
+        bytes += ptStats[i].bytes;
+    }
+    printf("  \x1B[1mtotal:\x1B[0m %zu pages, %zu B (%.1f B/page)\n", pages,
+           bytes, pages ? bytes / (double)pages : 0.0);
+}
+
+// A process finished at this time, after this many references and faults
+void Stat_process(Stats* s, unsigned long pid, unsigned long references,
+                  unsigned long faults, unsigned long time) {
+    if (s->procStatsLength == s->procStatsCapacity) {
+        s->procStatsCapacity =
+          s->procStatsCapacity ? s->procStatsCapacity * 2 : 16;
+        s->procStats =
+          realloc(s->procStats, s->procStatsCapacity * sizeof(*s->procStats));
+        if (s->procStats == NULL) {
+            perror("Error allocating memory for process stats.");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s->procStats[s->procStatsLength++] =
+      (struct proc_stat_t){pid, references, faults, time};
+}
+
+static int Stat_compareProcPid(const void* a, const void* b) {
+    unsigned long pa = ((const struct proc_stat_t*)a)->pid;
+    unsigned long pb = ((const struct proc_stat_t*)b)->pid;
+    return (pa > pb) - (pa < pb);
+}
+
+// Print every process's fault rate and finishing time, by pid, one column
+// per run; the runs must be of the same processes
+void Stat_printProcesses(const char* const* names, Stats* const* runs,
+                         size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        assert(runs[i]->procStatsLength == runs[0]->procStatsLength);
+        qsort(runs[i]->procStats, runs[i]->procStatsLength,
+              sizeof(*runs[i]->procStats), Stat_compareProcPid);
+    }
+
+    printf("\x1B[1m\x1B[7m%s\x1B[0m\n", " PROCESSES ");
+    printf("  faults per 1000 references / finishing time (ms)\n");
+    printf("  %10s %10s", "pid", "references");
+    for (size_t i = 0; i < n; i++) printf(" %20s", names[i]);
+    printf("\n");
+    for (size_t k = 0; k < runs[0]->procStatsLength; k++) {
+        const struct proc_stat_t* p = &runs[0]->procStats[k];
+        printf("  %10lu %10lu", p->pid, p->references);
+        for (size_t i = 0; i < n; i++) {
+            const struct proc_stat_t* r = &runs[i]->procStats[k];
+            assert(r->pid == p->pid);
+            printf(" %9.2f / %8.1f",
+                   r->references ? 1000.0 * r->faults / r->references : 0.0,
+                   r->finished / 1e6);
+        }
+        printf("\n");
+    }
 }
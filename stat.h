@@ -5,30 +5,103 @@
  * @author Julien de Castelnau and Michael Noguera
  */
 
-// 
+#ifndef _STAT_
+#define _STAT_
+
+#include "memory.h"
+#include "process.h"
+#include <stddef.h>
+
+// Page table size of one finished process
+struct pt_stat_t {
+    unsigned long pid;
+    size_t pages; // virtual pages mapped
+    size_t bytes; // memory held by the page table structure
+};
+
+// Paging behaviour of one finished process
+struct proc_stat_t {
+    unsigned long pid;
+    unsigned long references;
+    unsigned long faults;
+    unsigned long finished; // time the process finished, in ns
+};
 
 // The tmu and trp fields get converted into the correct amu and arp fields at the
 // point of the program exit, where they are divided by the total time.
-struct stat_t {
+typedef struct stat_t {
     unsigned long tmu; // total memory utilization (compounding)
     unsigned long trp; // total runable processes (compounding)
     unsigned long tmr; // total memory references
     unsigned long tpi; // total page ins: number of page faults
-};
 
-// Initialize stat structure
-void Stat_init();
+    // state of the simulation being measured
+    Memory* memory;
+    ProcessQueues* queues;
+
+    // page table sizes, appended as processes finish
+    struct pt_stat_t* ptStats;
+    size_t ptStatsLength;
+    size_t ptStatsCapacity;
+
+    // fault counts, appended as processes finish
+    struct proc_stat_t* procStats;
+    size_t procStatsLength;
+    size_t procStatsCapacity;
+} Stats;
+
+// Final results of a run, as printed
+typedef struct stat_summary_t {
+    float amu; // average memory utilization, as a fraction of memory
+    float arp; // average runnable processes
+    unsigned long tmr;
+    unsigned long tpi;
+    unsigned long time; // running time
+} StatSummary;
+
+// Initialize stat structure, for a simulation using this memory and queues
+void Stat_init(Stats* s, Memory* memory, ProcessQueues* queues);
+
+// Free stat structure
+void Stat_free(Stats* s);
 
 // No matter what happens this tick, this will still be called and still applies.
-void Stat_default(unsigned long numTicks);
+void Stat_default(Stats* s, unsigned long numTicks);
 
 // This tick, a hit happened
-void Stat_hit();
+void Stat_hit(Stats* s);
 
 // This tick, a miss happened
-void Stat_miss();
+void Stat_miss(Stats* s);
+
+// Compute the final results, given an end time for the program.
+StatSummary Stat_summarize(const Stats* s, unsigned long time);
 
 // Print the stats out directly, given an end time for the program.
-void Stat_printStats(unsigned long time);
+void Stat_printStats(const Stats* s, unsigned long time);
+
+// Print results that have already been summarized, the same way
+void Stat_printSummary(const StatSummary* r);
+
+// Print several runs' results next to each other, one column per name
+void Stat_printTable(const char* const* names, const StatSummary* results,
+                     size_t n);
+
+unsigned long Stat_tmr_so_far(const Stats* s);
+
+// A process finished with a page table of this size
+void Stat_pageTable(Stats* s, unsigned long pid, size_t pages, size_t bytes);
+
+// Print every finished process's page table size, by pid, and the totals
+void Stat_printPageTables(Stats* s);
+
+// A process finished at this time, after this many references and faults
+void Stat_process(Stats* s, unsigned long pid, unsigned long references,
+                  unsigned long faults, unsigned long time);
+
+// Print every process's fault rate and finishing time, by pid, one column
+// per run; the runs must be of the same processes
+void Stat_printProcesses(const char* const* names, Stats* const* runs,
+                         size_t n);
 
-unsigned long Stat_tmr_so_far();
+#endif
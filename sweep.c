@@ -0,0 +1,396 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file sweep.c
+ * @brief pfsim-sweep: runs every combination of a grid of policies, memory
+ * sizes and page sizes over one trace, in parallel, and writes the results
+ * as CSV.
+ * @details The trace goes through the first pass once, in columnar mode,
+ * into a template set of processes that every run clones (see
+ * ProcessQueues_clone), so the runs share one read-only copy of the trace.
+ * Runs are handed out by a work-stealing pool: each worker starts with its
+ * own deque of runs, takes from its back, and when it runs dry steals from
+ * the front of the others', so workers stuck with slow runs get relieved.
+ */
+#define _GNU_SOURCE
+
+#include "process.h"
+#include "replace.h"
+#include "simulator.h"
+#include "stat.h"
+#include "trace_parser.h"
+#include "trace_reader.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// long options without a short form
+enum { OPT_SEED = 256 };
+
+static const struct option longOptions[] = {
+  {"seed", required_argument, NULL, OPT_SEED},
+  {NULL, 0, NULL, 0},
+};
+
+// One point of the grid, and its results
+typedef struct sweep_run_t {
+    const ReplaceSpec* spec; // policy and its parameter
+    int memsize;  // MB
+    int pagesize; // bytes
+    StatSummary result;
+} SweepRun;
+
+// Runs not yet taken by a worker, jobs[head..tail)
+typedef struct sweep_deque_t {
+    pthread_mutex_t lock;
+    size_t* jobs; // indices into the runs
+    size_t head;  // thieves take from here
+    size_t tail;  // the owner takes from here
+} SweepDeque;
+
+// Everything the workers share
+typedef struct sweep_pool_t {
+    SweepDeque* deques; // one per worker
+    int workers;
+    SweepRun* runs;
+    const ProcessQueues* template; // processes from the first pass
+    SimulatorEngine engine;
+} SweepPool;
+
+// Arguments of one worker thread
+typedef struct sweep_worker_t {
+    SweepPool* pool;
+    int id;
+} SweepWorker;
+
+/**
+ * Parses a comma separated list of positive integers
+ * @param[out] n number of values
+ * @return the values, malloc'd, or NULL if the list is invalid
+ */
+static int* Sweep_parseList(char* list, size_t* n) {
+    size_t capacity = 1;
+    for (char* c = list; *c != '\0'; c++) capacity += (*c == ',');
+    int* values = malloc(capacity * sizeof(int));
+    if (values == NULL) {
+        perror("Error allocating memory for sweep grid.");
+        exit(EXIT_FAILURE);
+    }
+
+    *n = 0;
+    char* save = NULL;
+    for (char* item = strtok_r(list, ",", &save); item != NULL;
+         item = strtok_r(NULL, ",", &save)) {
+        char* end;
+        errno = 0;
+        long value = strtol(item, &end, 10);
+        if (errno != 0 || *end != '\0' || value < 1 || value > 1 << 30) {
+            free(values);
+            return NULL;
+        }
+        values[(*n)++] = (int)value;
+    }
+    if (*n == 0) {
+        free(values);
+        return NULL;
+    }
+    return values;
+}
+
+/**
+ * Takes the next run for a worker: the newest of its own, or else the
+ * oldest of another worker's.
+ * @return false once every deque is empty
+ */
+static bool Sweep_take(SweepPool* pool, int id, size_t* job) {
+    for (int k = 0; k < pool->workers; k++) {
+        SweepDeque* d = &pool->deques[(id + k) % pool->workers];
+        bool found = false;
+        pthread_mutex_lock(&d->lock);
+        if (d->head < d->tail) {
+            *job = (k == 0) ? d->jobs[--d->tail] : d->jobs[d->head++];
+            found = true;
+        }
+        pthread_mutex_unlock(&d->lock);
+        if (found) return true;
+    }
+    return false; // no run is ever added, so this one's done
+}
+
+/** Runs one point of the grid on its own clone of the processes */
+static void Sweep_run(SweepPool* pool, SweepRun* run) {
+    Simulator sim;
+    int frames = run->memsize * 0x100000 / run->pagesize;
+    Simulator_init(&sim, run->spec, frames);
+    ProcessQueues_clone(&sim.queues, pool->template);
+    unsigned long time = Simulator_runSimulation(&sim, NULL, pool->engine);
+    run->result = Stat_summarize(&sim.stats, time);
+    Simulator_free(&sim);
+}
+
+/** Worker thread body: runs grid points until none are left */
+static void* Sweep_worker(void* arg) {
+    SweepWorker* w = arg;
+    size_t job;
+    while (Sweep_take(w->pool, w->id, &job)) {
+        Sweep_run(w->pool, &w->pool->runs[job]);
+    }
+    return NULL;
+}
+
+/** Prints the usage message */
+static void Sweep_usage(const char* name) {
+    printf("Usage:\n");
+    printf("  ./%s [-a policies] [-m memory sizes] [-p page sizes] "
+           "[-j threads]\n\t[-e engine] [-o csv file] [--seed N] "
+           "<tracefile>\n",
+           name);
+    printf("\nRuns every combination of the given lists, each comma "
+           "separated, and\nwrites one CSV line of results per "
+           "combination.\n");
+    printf("\nOptions:\n");
+    printf("  -h\tPrints this message.\n");
+    printf("  -a\tReplacement policies, each one of\n\t" REPLACE_POLICY_NAMES
+           ".\n\tA policy may be listed more than once with different "
+           "parameters.\n\tDefaults to all of them, with default "
+           "parameters.\n");
+    printf("  -m\tMemory sizes, in megabytes. Defaults to 1.\n");
+    printf("  -p\tPage sizes, in bytes, each a power of two. Defaults to "
+           "4096.\n");
+    printf("  -j\tNumber of threads, for the first pass and the runs. "
+           "Defaults to the\n\tnumber of online CPUs.\n");
+    printf("  -e\tSimulation engine, 'event' or 'tick'. Defaults to "
+           "event.\n");
+    printf("  -o\tFile to write the CSV to. Defaults to standard output.\n");
+    printf("  --seed N\n\tSeeds the generator of each policy that draws "
+           "frames at random (random\n\tand sampled), in every run. "
+           "Defaults to 1.\n");
+}
+
+/**
+ * Parses the grid, reads the trace once, runs the grid on a pool of threads
+ * and writes the CSV.
+ * @return EXIT_SUCCESS on success and EXIT_FAILURE on failure
+ */
+int main(int argc, char** argv) {
+    const char* name = argc > 0 ? basename(argv[0]) : "pfsim-sweep";
+    ReplaceSpec policies[REPLACE_MAX_POLICIES];
+    int numPolicies = NUM_REPLACE_POLICIES;
+    for (int i = 0; i < numPolicies; i++) {
+        Replace_parsePolicy(Replace_policyName(i), &policies[i]);
+    }
+    int defaultMemsize = 1;
+    int defaultPagesize = 4096;
+    int* memsizes = &defaultMemsize;
+    int* pagesizes = &defaultPagesize;
+    size_t numMemsizes = 1;
+    size_t numPagesizes = 1;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    SimulatorEngine engine = ENGINE_EVENT;
+    const char* output = NULL;
+    char* filename = NULL;
+    unsigned long long seed = 1;
+
+    // 1. Parse the grid
+    int opt;
+    while ((opt = getopt_long(argc, argv, "-a:m:p:j:e:o:h", longOptions,
+                              NULL))
+           != -1) {
+        switch (opt) {
+            case OPT_SEED: {
+                char* end;
+                errno = 0;
+                seed = strtoull(optarg, &end, 10);
+                if (errno != 0 || end == optarg || *end != '\0'
+                    || optarg[0] == '-') {
+                    fprintf(stderr, "Error parsing --seed, must be a "
+                                    "non-negative integer.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 'a':
+                numPolicies = Replace_parsePolicyList(optarg, policies);
+                if (numPolicies == 0) {
+                    fprintf(stderr, "Error parsing -a, must be a list of "
+                                    "distinct policies, each one of\n\t"
+                                    REPLACE_POLICY_NAMES ".\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'm':
+                memsizes = Sweep_parseList(optarg, &numMemsizes);
+                if (memsizes == NULL) {
+                    fprintf(stderr, "Error parsing -m, must be a list of "
+                                    "positive integers.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'p':
+                pagesizes = Sweep_parseList(optarg, &numPagesizes);
+                if (pagesizes == NULL) {
+                    fprintf(stderr, "Error parsing -p, must be a list of "
+                                    "positive integers.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'j': {
+                char* end;
+                errno = 0;
+                threads = strtol(optarg, &end, 10);
+                if (errno != 0 || end == optarg || *end != '\0'
+                    || threads < 1) {
+                    fprintf(stderr,
+                            "Error parsing -j, must be a positive integer.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 'e':
+                if (strcmp(optarg, "event") == 0) {
+                    engine = ENGINE_EVENT;
+                } else if (strcmp(optarg, "tick") == 0) {
+                    engine = ENGINE_TICK;
+                } else {
+                    fprintf(stderr,
+                            "Error parsing -e, must be 'event' or 'tick'.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'h':
+                Sweep_usage(name);
+                exit(EXIT_FAILURE);
+            case '?':
+                printf("Try '%s -h' for more information.\n", name);
+                exit(EXIT_FAILURE);
+            default:
+                filename = optarg;
+                break;
+        }
+    }
+    if (filename == NULL) {
+        fprintf(stderr,
+                "ERROR: must specify valid file name on command line\n");
+        exit(EXIT_FAILURE);
+    }
+    if (threads < 1) threads = 1;
+    for (int a = 0; a < numPolicies; a++) policies[a].seed = seed;
+
+    // every point of the grid has to be a valid pfsim run
+    for (size_t m = 0; m < numMemsizes; m++) {
+        if (memsizes[m] >= 2048) {
+            fprintf(stderr, "ERROR: memory size must be under 2048 MB\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (size_t p = 0; p < numPagesizes; p++) {
+        if ((pagesizes[p] & (pagesizes[p] - 1)) != 0) {
+            fprintf(stderr, "ERROR: page size must be a power of two\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t m = 0; m < numMemsizes; m++) {
+            if (pagesizes[p] > memsizes[m] * 0x100000) {
+                fprintf(stderr, "ERROR: page size %i is larger than memory "
+                                "size %i MB\n",
+                        pagesizes[p], memsizes[m]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    FILE* out = stdout;
+    if (output != NULL && (out = fopen(output, "w")) == NULL) {
+        perror("Error opening CSV file.");
+        exit(EXIT_FAILURE);
+    }
+
+    // 2. Read the trace once; the runs only need the columns
+    Trace* trace = Trace_open(filename);
+    ProcessQueues template;
+    ProcessQueues_init(&template);
+    first_pass(&template, trace, true, NULL, (int)threads);
+    Trace_close(trace);
+    for (int a = 0; a < numPolicies; a++) {
+        if (policies[a].policy == REPLACE_OPT) {
+            first_pass_nextUse(&template); // once, shared by every clone
+            break;
+        }
+    }
+
+    // 3. Lay out the grid, dealing runs out to the workers round robin
+    size_t numRuns = numPolicies * numMemsizes * numPagesizes;
+    SweepRun* runs = malloc(numRuns * sizeof(SweepRun));
+    SweepDeque* deques = malloc(threads * sizeof(SweepDeque));
+    SweepWorker* workers = malloc(threads * sizeof(SweepWorker));
+    pthread_t* ids = malloc(threads * sizeof(pthread_t));
+    if (runs == NULL || deques == NULL || workers == NULL || ids == NULL) {
+        perror("Error allocating memory for sweep.");
+        exit(EXIT_FAILURE);
+    }
+    for (long w = 0; w < threads; w++) {
+        pthread_mutex_init(&deques[w].lock, NULL);
+        deques[w].jobs = malloc((numRuns / threads + 1) * sizeof(size_t));
+        if (deques[w].jobs == NULL) {
+            perror("Error allocating memory for sweep.");
+            exit(EXIT_FAILURE);
+        }
+        deques[w].head = deques[w].tail = 0;
+    }
+    size_t i = 0;
+    for (int a = 0; a < numPolicies; a++) {
+        for (size_t m = 0; m < numMemsizes; m++) {
+            for (size_t p = 0; p < numPagesizes; p++, i++) {
+                runs[i] = (SweepRun){&policies[a], memsizes[m], pagesizes[p],
+                                     {0, 0, 0, 0, 0}};
+                SweepDeque* d = &deques[i % threads];
+                d->jobs[d->tail++] = i;
+            }
+        }
+    }
+
+    // 4. Run the grid
+    SweepPool pool = {deques, (int)threads, runs, &template, engine};
+    for (long w = 0; w < threads; w++) {
+        workers[w] = (SweepWorker){&pool, (int)w};
+        errno = pthread_create(&ids[w], NULL, Sweep_worker, &workers[w]);
+        if (errno != 0) {
+            perror("Couldn't start sweep worker thread.");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (long w = 0; w < threads; w++) pthread_join(ids[w], NULL);
+
+    // 5. Write the results, in grid order
+    fprintf(out, "policy,memory_mb,page_size,frames,amu,arp,tmr,tpi,rtime\n");
+    for (i = 0; i < numRuns; i++) {
+        SweepRun* r = &runs[i];
+        fprintf(out, "%s,%i,%i,%i,%f,%f,%lu,%lu,%lu\n",
+                r->spec->name, r->memsize, r->pagesize,
+                r->memsize * 0x100000 / r->pagesize, r->result.amu,
+                r->result.arp, r->result.tmr, r->result.tpi, r->result.time);
+    }
+    if (out != stdout) fclose(out);
+
+    // 6. Clean up
+    for (long w = 0; w < threads; w++) {
+        pthread_mutex_destroy(&deques[w].lock);
+        free(deques[w].jobs);
+    }
+    ProcessQueues_free(&template);
+    if (memsizes != &defaultMemsize) free(memsizes);
+    if (pagesizes != &defaultPagesize) free(pagesizes);
+    free(ids);
+    free(workers);
+    free(deques);
+    free(runs);
+    return EXIT_SUCCESS;
+}
@@ -16,6 +16,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <search.h>
 #include <stdio.h>
 
@@ -38,14 +39,12 @@ static int compare(const void* l, const void* r) {
     }
 }
 
+// one is taken per run of lines and given back unless the pid is new
+static Pool pidMapPool = POOL_INITIALIZER("PidMap", struct PidMap);
+
 // Pidmap constructor
 static struct PidMap* make_PidMap(int pid) {
-    struct PidMap* new_PidMap;
-    if ((new_PidMap = (struct PidMap*)malloc(sizeof(struct PidMap))) == NULL) {
-        perror("Failed to allocate memory for new PID->Proces* map node.");
-        exit(EXIT_FAILURE);
-    }
-
+    struct PidMap* new_PidMap = Pool_alloc(&pidMapPool);
     new_PidMap->pid = pid;
     new_PidMap->owner = NULL;
 
@@ -56,100 +55,362 @@ static struct PidMap* make_PidMap(int pid) {
 static void PidMap_free(void* PidMap) {
     struct PidMap* pdh = PidMap;
     if (!pdh) { return; }
-    free(pdh);
+    Pool_free(&pidMapPool, pdh);
     return;
 }
 
 /**
- * Runs a first pass over the specified trace file, passed using a FILE*
- * pointer. After running this function, all Process structs will be in the
- * RUNNABLE ProcessQueue.
- * @param trace_file file provided as input
+ * Closes out a run of consecutive lines from one process: finds the process
+ * (creating it on its first run) and adds the run to its interval tree.
+ * @param q queues the process is created in
+ * @param search_tree tsearch tree of PidMaps seen so far
+ * @param pid process the run belongs to
+ * @param first line number of the first line of the run
+ * @param last line number of the last line of the run
+ * @param fpos trace position of the first line of the run
+ * @return the process that owns the run
+ */
+static Process* first_pass_closeRun(ProcessQueues* q, void** search_tree,
+                                    unsigned long pid, unsigned long first,
+                                    unsigned long last, long fpos) {
+    struct PidMap* new_pdm;       // interval tree query
+    struct PidMap* search_result; // result of tsearch
+    new_pdm = make_PidMap(pid);   // create the search query based on PID
+    search_result = tsearch(new_pdm, search_tree, compare);
+    if (search_result == 0) {
+        perror("Error searching for pid holder node.");
+        exit(EXIT_FAILURE);
+    }
+
+    // The tsearch query did not fail. Was it inserted or was an
+    // existing entry found?
+    struct PidMap* existing = *(struct PidMap**)search_result;
+    if (existing != new_pdm) {
+        // An existing result was found.
+        // Merge intervals in the current occurrence and the
+        // existing occurrence, using it_insert().
+        PidMap_free(new_pdm);
+
+        assert(existing->owner != NULL);
+        Process_addInterval(existing->owner, first, last, fpos);
+        return existing->owner;
+    } else {
+        // no process existed, create one
+        new_pdm->owner = Process_init(q, pid, first, last, fpos);
+        return new_pdm->owner;
+    }
+}
+
+/**
+ * Runs a first pass over the specified trace. After running this function, all
+ * Process structs will be in the RUNNABLE ProcessQueue.
+ * @param q queues to create the processes in
+ * @param trace trace provided as input
+ * @param columns if true, also copy each process's VPNs into its RefColumn
+ * @param sample if not NULL, lines of pages it doesn't keep are skipped
  */
-void first_pass(FILE* trace_file) {
-    assert(trace_file != NULL);
+static void first_pass_serial(ProcessQueues* q, Trace* trace, bool columns,
+                              const Sample* sample) {
+    assert(trace != NULL);
 
     void* search_tree = 0; // search tree to store already seen PIDs in
+    RefColumn run = {NULL, 0, 0, NULL}; // VPNs of the current run, -c only
 
     // track fields for current process
     unsigned long pid = 0;
     unsigned long start_line_number = 1;
-    long start_fpos;
+    long start_fpos = Trace_tell(trace);
     long curr_fpos;
-    if ((start_fpos = ftell(trace_file)) == -1) {
-        perror("Error retrieving file position in tracefile.");
-        exit(EXIT_FAILURE);
-    }
     unsigned long curr_line_number = 1;
+    unsigned long raw_line_number = 1; // counting skipped lines too
 
-    int fscanf_result = 0;
+    bool read_result = false;
     do {
-        if ((curr_fpos = ftell(trace_file)) == -1) {
-            perror("Error retrieving file position in tracefile.");
-            exit(EXIT_FAILURE);
-        }
+        curr_fpos = Trace_tell(trace);
 
-        unsigned long curr_pid;
+        unsigned long curr_pid = 0;
         unsigned long curr_vpn;
-         // Parse current line using fscanf
-        fscanf_result = fscanf(trace_file, "%lu %lu", &curr_pid, &curr_vpn);
-        if (curr_pid == 0 && fscanf_result >= 0) {
+        read_result = Trace_next(trace, &curr_pid, &curr_vpn);
+        if (curr_pid == 0 && read_result) {
             fprintf(stderr, "ERROR: Invalid trace file format at line %ld",
-                    curr_line_number);
+                    raw_line_number);
             exit(EXIT_FAILURE);
         }
+        raw_line_number++;
+
+        // an unsampled line isn't there as far as the simulation knows
+        if (read_result && sample != NULL
+            && !Sample_keep(sample, curr_pid, curr_vpn)) {
+            continue;
+        }
 
         // Was the PID found on current line different than the last? enter
         // condition for creating a new Process* struct and adding to
         // list/queue.
-        if (pid != 0 && (curr_pid != pid || fscanf_result <= 0)) {
-            struct PidMap* new_pdm;       // interval tree query
-            struct PidMap* search_result; // result of tsearch
-            new_pdm = make_PidMap(pid); // create the search query based on PID
-            search_result = tsearch(new_pdm, &search_tree, compare);
-            if (search_result == 0) {
-                perror("Error searching for pid holder node.");
-                exit(EXIT_FAILURE);
-            } else {
-                // The tsearch query did not fail. Was it inserted or was an
-                // existing entry found?
-                struct PidMap* existing = *(struct PidMap**)search_result;
-                if (existing != new_pdm) {
-                    // An existing result was found.
-                    // Merge intervals in the current occurrence and the
-                    // existing occurrence, using it_insert().
-                    PidMap_free(new_pdm);
-
-                    assert(existing->owner != NULL);
-                    existing->owner->lastline =
-                      (existing->owner->lastline < curr_line_number - 1)
-                        ? curr_line_number - 1
-                        : existing->owner->lastline;
-
-                    IntervalNode* new_IntervalNode =
-                      it_initnode(start_line_number, curr_line_number - 1);
-                    it_setFpos(new_IntervalNode, start_fpos);
-                    it_insert(existing->owner->lineIntervals, new_IntervalNode);
-                } else {
-                    // no process existed, create one
-                    IntervalNode* new_IntervalNode =
-                      it_initnode(start_line_number, curr_line_number - 1);
-                    it_setFpos(new_IntervalNode, start_fpos);
-                    Process* curr_proc =
-                      Process_init(pid, start_line_number, curr_line_number - 1,
-                                   new_IntervalNode);
-
-                    new_pdm->owner = curr_proc; // update the owner of the entry
-                                                // in the search tree
-                }
-                start_fpos = curr_fpos;
-                start_line_number = curr_line_number; // reset start_line_number
+        if (pid != 0 && (curr_pid != pid || !read_result)) {
+            Process* owner =
+              first_pass_closeRun(q, &search_tree, pid, start_line_number,
+                                  curr_line_number - 1, start_fpos);
+            if (columns) {
+                RefColumn_append(&owner->refs, run.vpns, run.length);
+                run.length = 0;
             }
+            start_fpos = curr_fpos;
+            start_line_number = curr_line_number; // reset start_line_number
         }
 
+        if (columns && read_result) RefColumn_append(&run, &curr_vpn, 1);
+
         pid = curr_pid;
         curr_line_number++;
-    } while (fscanf_result > 0);
+    } while (read_result);
 
+    RefColumn_free(&run);
     tdestroy(search_tree, PidMap_free); // destroy search tree
-}
\ No newline at end of file
+}
+
+// === PARALLEL FIRST PASS ===
+
+// A run of consecutive lines from one process, found by a chunk worker
+typedef struct pid_run_t {
+    unsigned long pid;
+    unsigned long length; // lines
+    long fpos;            // trace position of the first line
+} PidRun;
+
+// One piece of the trace and what a worker found in it
+typedef struct chunk_t {
+    Trace cursor; // private copy of the trace, reads [begin, end)
+    long begin;
+    long end;
+    bool columns;
+    const Sample* sample; // NULL to keep every line
+
+    PidRun* runs; // in trace order
+    size_t numRuns;
+    size_t runsCapacity;
+    RefColumn vpns;          // every VPN in the chunk, in columns mode
+    unsigned long lines;     // lines kept
+    unsigned long rawLines;  // lines read, including any not sampled
+    unsigned long badLine;   // line within the chunk with pid 0, or 0 if none
+} Chunk;
+
+// Work queue shared by the pool: workers claim chunks by index
+typedef struct chunk_pool_t {
+    Chunk* chunks;
+    size_t numChunks;
+    size_t nextChunk; // next unclaimed chunk, advanced atomically
+} ChunkPool;
+
+/** Scans one chunk into its run list */
+static void first_pass_scanChunk(Chunk* c) {
+    Trace_seek(&c->cursor, c->begin);
+
+    unsigned long pid;
+    unsigned long vpn;
+    while (Trace_tell(&c->cursor) < c->end) {
+        long fpos = Trace_tell(&c->cursor);
+        if (!Trace_next(&c->cursor, &pid, &vpn)) break;
+        c->rawLines++;
+        if (pid == 0) {
+            c->badLine = c->rawLines;
+            return;
+        }
+        if (c->sample != NULL && !Sample_keep(c->sample, pid, vpn)) continue;
+        c->lines++;
+
+        if (c->numRuns == 0 || c->runs[c->numRuns - 1].pid != pid) {
+            if (c->numRuns == c->runsCapacity) {
+                c->runsCapacity = c->runsCapacity ? 2 * c->runsCapacity : 64;
+                c->runs = realloc(c->runs, c->runsCapacity * sizeof(PidRun));
+                if (c->runs == NULL) {
+                    perror("Couldn't allocate memory for trace runs.");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            c->runs[c->numRuns++] = (PidRun){pid, 0, fpos};
+        }
+        c->runs[c->numRuns - 1].length++;
+        if (c->columns) RefColumn_append(&c->vpns, &vpn, 1);
+    }
+}
+
+/** Pool worker: scans chunks until none are left */
+static void* first_pass_worker(void* arg) {
+    ChunkPool* pool = arg;
+    size_t i;
+    while ((i = __atomic_fetch_add(&pool->nextChunk, 1, __ATOMIC_RELAXED))
+           < pool->numChunks) {
+        first_pass_scanChunk(&pool->chunks[i]);
+    }
+    return NULL;
+}
+
+/**
+ * Same result as first_pass_serial, but the trace is cut into chunks on line
+ * boundaries and the chunks are scanned into run lists on a pool of threads.
+ * The run lists are then stitched together where a run crosses a chunk
+ * boundary and closed in trace order, exactly as the serial pass would.
+ * @param threads number of worker threads
+ */
+static void first_pass_parallel(ProcessQueues* q, Trace* trace, bool columns,
+                                const Sample* sample, int threads) {
+    assert(trace != NULL && threads > 1);
+
+    // a few chunks per thread, so one slow chunk doesn't idle the others
+    size_t wanted = 4 * (size_t)threads;
+    long* bounds = malloc((wanted + 1) * sizeof(long));
+    Chunk* chunks = calloc(wanted, sizeof(Chunk));
+    pthread_t* workers = malloc(threads * sizeof(pthread_t));
+    if (bounds == NULL || chunks == NULL || workers == NULL) {
+        perror("Couldn't allocate memory for parallel first pass.");
+        exit(EXIT_FAILURE);
+    }
+
+    ChunkPool pool = {chunks, Trace_split(trace, wanted, bounds), 0};
+    for (size_t i = 0; i < pool.numChunks; i++) {
+        chunks[i].cursor = *trace;
+        chunks[i].begin = bounds[i];
+        chunks[i].end = bounds[i + 1];
+        chunks[i].columns = columns;
+        chunks[i].sample = sample;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        errno = pthread_create(&workers[i], NULL, first_pass_worker, &pool);
+        if (errno != 0) {
+            perror("Couldn't start first pass worker thread.");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+
+    // merge: walk the runs in trace order, extending the open run while the
+    // pid stays the same, including across chunk boundaries
+    void* search_tree = 0;
+    PidRun open = {0, 0, 0};
+    unsigned long open_first = 1; // line number of open run's first line
+    size_t open_chunk = 0;        // where the open run's VPNs start
+    size_t open_offset = 0;
+    unsigned long line = 1;
+    unsigned long rawLine = 1; // first line of chunk i, for errors
+
+    for (size_t i = 0; i <= pool.numChunks; i++) {
+        bool last = (i == pool.numChunks);
+        Chunk* c = last ? NULL : &chunks[i];
+        if (!last && c->badLine != 0) {
+            fprintf(stderr, "ERROR: Invalid trace file format at line %ld",
+                    rawLine + c->badLine - 1);
+            exit(EXIT_FAILURE);
+        }
+        if (!last) rawLine += c->rawLines;
+
+        size_t numRuns = last ? 1 : c->numRuns;
+        size_t offset = 0; // of the current run's VPNs within the chunk
+        for (size_t r = 0; r < numRuns; r++) {
+            PidRun run = last ? (PidRun){0, 0, 0} : c->runs[r];
+            if (open.length > 0 && run.pid == open.pid) {
+                open.length += run.length;
+            } else {
+                if (open.length > 0) {
+                    Process* owner = first_pass_closeRun(
+                      q, &search_tree, open.pid, open_first,
+                      open_first + open.length - 1, open.fpos);
+                    // the open run's VPNs may span several chunks
+                    size_t stop = last ? i - 1 : i;
+                    for (size_t k = open_chunk; columns && k <= stop; k++) {
+                        size_t from = (k == open_chunk) ? open_offset : 0;
+                        size_t to = (k == i) ? offset : chunks[k].vpns.length;
+                        RefColumn_append(&owner->refs,
+                                         chunks[k].vpns.vpns + from, to - from);
+                    }
+                }
+                open = run;
+                open_first = line;
+                open_chunk = i;
+                open_offset = offset;
+            }
+            line += run.length;
+            offset += run.length;
+        }
+    }
+
+    for (size_t i = 0; i < pool.numChunks; i++) {
+        free(chunks[i].runs);
+        RefColumn_free(&chunks[i].vpns);
+    }
+    tdestroy(search_tree, PidMap_free);
+    free(workers);
+    free(chunks);
+    free(bounds);
+}
+
+/**
+ * Runs a first pass over the specified trace. After running this function, all
+ * Process structs will be in the RUNNABLE ProcessQueue.
+ * @param q queues to create the processes in
+ * @param trace trace provided as input
+ * @param columns if true, also copy each process's VPNs into its RefColumn
+ * @param sample if not NULL, lines of pages it doesn't keep are skipped
+ * @param threads number of threads to scan the trace with
+ */
+void first_pass(ProcessQueues* q, Trace* trace, bool columns,
+                const Sample* sample, int threads) {
+    assert(sample == NULL || columns);
+    if (threads > 1) {
+        first_pass_parallel(q, trace, columns, sample, threads);
+    } else {
+        first_pass_serial(q, trace, columns, sample);
+    }
+}
+
+// === NEXT USE INDEX ===
+
+/**
+ * Fills in one process's next-use index. Line numbers come from the
+ * process's intervals, which are chained in trace order through their right
+ * children; each page's latest line so far is kept in a throwaway page table.
+ */
+static void first_pass_nextUseOf(Process* p) {
+    RefColumn* c = &p->refs;
+    unsigned long* next = malloc(c->length * sizeof(*next));
+    if (next == NULL) {
+        perror("Couldn't allocate memory for next-use index.");
+        exit(EXIT_FAILURE);
+    }
+
+    // line of every reference, forward
+    size_t i = 0;
+    for (IntervalNode* n = p->lineIntervals; n != NULL; n = n->right) {
+        for (size_t line = n->low; line <= n->high; line++) next[i++] = line;
+    }
+    assert(i == c->length && "column doesn't match intervals");
+
+    // then the line of the reference after it, backward
+    Arena arena;
+    Arena_init(&arena);
+    PageTable* seen = PageTable_init(&arena, NULL);
+    while (i-- > 0) {
+        bool inMemory;
+        VPage* v = PageTable_getOrInsert(seen, p->pid, c->vpns[i], &inMemory);
+        unsigned long line = next[i];
+        next[i] = v->meta.nextUse.line != 0 ? v->meta.nextUse.line : REF_NEVER;
+        v->meta.nextUse.line = line;
+    }
+    PageTable_release(seen);
+    Arena_release(&arena);
+
+    c->nextUse = next;
+}
+
+size_t first_pass_nextUse(ProcessQueues* q) {
+    assert(STAILQ_EMPTY(&q->pq[BLOCKED]) && STAILQ_EMPTY(&q->pq[FINISHED]));
+    size_t bytes = 0;
+    Process* p;
+    STAILQ_FOREACH(p, &q->pq[RUNNABLE], procs) {
+        assert(p->refs.length > 0 && "needs a first pass in columns mode");
+        if (p->refs.nextUse == NULL) first_pass_nextUseOf(p);
+        bytes += p->refs.length * sizeof(*p->refs.nextUse);
+    }
+    return bytes;
+}
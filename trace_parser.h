@@ -11,20 +11,43 @@
 #define _TRACE_PARSER_
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "memory.h"
 #include "process.h"
+#include "sample.h"
+#include "trace_reader.h"
 
 /**
- * Runs a first pass over the specified trace file, passed using a FILE*
- * pointer. Organizes a priority queue for each chunk of PID reference lines
- * found, and merges their intervals into an interval tree
+ * Runs a first pass over the specified trace. Organizes a priority queue for
+ * each chunk of PID reference lines found, and merges their intervals into an
+ * interval tree, decorated with trace positions.
  *
- * @param trace_file FILE* pointing to the trace file
- * @param The process queue to contain the synthesized process data
+ * @param q queues to create the processes in, in the RUNNABLE queue
+ * @param trace trace opened with Trace_open
+ * @param columns if true, also decode each process's VPNs into its RefColumn
+ * so the simulation can run without the trace
+ * @param sample if not NULL, only lines referencing pages it keeps are read,
+ * numbered as if the others weren't there; needs columns, since the
+ * simulation can't skip lines when reading the trace itself
+ * @param threads if more than 1, the trace is cut into chunks on line
+ * boundaries that are scanned on this many threads, then merged; the
+ * resulting processes are the same either way
  */
-void first_pass(FILE* trace_file);
+void first_pass(ProcessQueues* q, Trace* trace, bool columns,
+                const Sample* sample, int threads);
+
+/**
+ * Indexes the future of the trace, for OPT: walks each process's RefColumn
+ * backward, recording for every reference the trace line of the next
+ * reference to the same page (RefColumn.nextUse). A page belongs to one
+ * process, so this is the same as a backward pass over the whole trace.
+ *
+ * @param q processes from a first_pass in columns mode, not yet run
+ * @return bytes of the index, 8 per reference
+ */
+size_t first_pass_nextUse(ProcessQueues* q);
 
 #endif
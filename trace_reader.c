@@ -0,0 +1,429 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file trace_reader.c
+ * @brief Reads memory references out of text or binary trace files.
+ * @details Both formats are mapped whole. Binary traces are indexed directly,
+ * so reading a reference is an array access and seeking is an assignment.
+ * Text traces are parsed in place: a 32 byte window at the cursor is
+ * classified into digit and whitespace bitmasks with SIMD compares, the
+ * "pid vpn" tokens are cut out of those masks with ctz, and each token is
+ * decoded 8 digits at a time with SWAR multiplies. Lines that don't fit in a
+ * window (or sit at the very end of the file) take a scalar path that accepts
+ * exactly the same input, so either way the result matches
+ * fscanf("%lu %lu\n").
+ */
+
+#include "trace_reader.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#    define TRACE_HAVE_X86_SIMD 1
+#endif
+
+// bytes classified at once; the fast path needs WINDOW + 8 readable bytes so
+// an 8 byte SWAR load starting anywhere in the window stays in the mapping
+enum { WINDOW = 32, WINDOW_SLACK = WINDOW + 8 };
+
+// === TEXT PARSING ===
+
+typedef struct char_masks_t {
+    uint64_t digits; // bit i set if byte i is '0'..'9'
+    uint64_t spaces; // bit i set if byte i is whitespace, as isspace()
+} CharMasks;
+
+static inline bool isDigit(char c) { return (unsigned char)(c - '0') < 10; }
+
+static inline bool isSpace(char c) {
+    return c == ' ' || (unsigned char)(c - '\t') < 5; // \t \n \v \f \r
+}
+
+/** Portable classifier, used when no SIMD unit is available */
+static inline CharMasks classify_scalar(const char* p) {
+    CharMasks m = {0, 0};
+    for (int i = 0; i < WINDOW; i++) {
+        m.digits |= (uint64_t)isDigit(p[i]) << i;
+        m.spaces |= (uint64_t)isSpace(p[i]) << i;
+    }
+    return m;
+}
+
+#ifdef TRACE_HAVE_X86_SIMD
+/** 16 bytes at a time with the SSE4.2 string compare unit's range mode */
+__attribute__((target("sse4.2"))) static inline CharMasks
+classify_sse42(const char* p) {
+    const __m128i digitRange = _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 0, 0, 0, 0, 0);
+    const __m128i spaceRange = _mm_setr_epi8(' ', ' ', '\t', '\r', 0, 0, 0, 0,
+                                             0, 0, 0, 0, 0, 0, 0, 0);
+#    define RANGE_MODE (_SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_BIT_MASK)
+
+    CharMasks m = {0, 0};
+    for (int half = 0; half < WINDOW / 16; half++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * half));
+        uint64_t d = (uint16_t)_mm_cvtsi128_si32(
+          _mm_cmpestrm(digitRange, 2, v, 16, RANGE_MODE));
+        uint64_t s = (uint16_t)_mm_cvtsi128_si32(
+          _mm_cmpestrm(spaceRange, 4, v, 16, RANGE_MODE));
+        m.digits |= d << (16 * half);
+        m.spaces |= s << (16 * half);
+    }
+    return m;
+#    undef RANGE_MODE
+}
+
+/** The whole window in one register: unsigned range checks via min/cmpeq */
+__attribute__((target("avx2"))) static inline CharMasks
+classify_avx2(const char* p) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+
+    __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    __m256i isD =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+
+    __m256i c = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i isC =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(c, _mm256_set1_epi8(4)), c);
+    __m256i isS = _mm256_or_si256(isC,
+                                  _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+
+    CharMasks m;
+    m.digits = (uint32_t)_mm256_movemask_epi8(isD);
+    m.spaces = (uint32_t)_mm256_movemask_epi8(isS);
+    return m;
+}
+#endif
+
+/** Decodes 8 ASCII digits packed little-endian into a word, most significant
+ * digit in the lowest byte */
+static inline uint64_t decodeEightDigits(uint64_t val) {
+    const uint64_t mask = 0x000000FF000000FF;
+    const uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+    val -= 0x3030303030303030;
+    val = (val * 10) + (val >> 8);
+    val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+    return val;
+}
+
+/** Decodes 1-8 digits at s, reading 8 bytes regardless */
+static inline uint64_t decodeDigitsSWAR(const char* s, unsigned n) {
+    assert(n >= 1 && n <= 8);
+    uint64_t val;
+    memcpy(&val, s, sizeof(val));
+    // right-align the digits and pad with leading '0's
+    unsigned pad = 8 * (8 - n);
+    val <<= pad;
+    val |= 0x3030303030303030 & ~(UINT64_MAX << pad);
+    return decodeEightDigits(val);
+}
+
+/** Decodes n digits at s; s + 8 must be readable if n <= 16 */
+static inline unsigned long decodeDigits(const char* s, unsigned n) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (n <= 8) return decodeDigitsSWAR(s, n);
+    if (n <= 16) {
+        return decodeDigitsSWAR(s, n - 8) * 100000000
+               + decodeDigitsSWAR(s + n - 8, 8);
+    }
+#endif
+    unsigned long x = 0;
+    for (unsigned i = 0; i < n; i++) x = x * 10 + (s[i] - '0');
+    return x;
+}
+
+/** Exits with a message that points at the offending byte */
+static void Trace_badText(size_t ofs) {
+    fprintf(stderr,
+            "ERROR: Error reading from trace file, expected \"pid vpn\" at "
+            "byte %zu.\n",
+            ofs);
+    exit(EXIT_FAILURE);
+}
+
+/** Parses one line byte by byte, accepting what fscanf("%lu %lu\n") would */
+static bool Trace_nextTextScalar(Trace* t, unsigned long* pid,
+                                 unsigned long* vpn) {
+    const char* s = t->map;
+    size_t len = t->mapLength;
+    size_t i = t->cursor;
+
+    while (i < len && isSpace(s[i])) i++;
+    if (i == len) {
+        t->cursor = i;
+        return false;
+    }
+
+    unsigned long* fields[2] = {pid, vpn};
+    for (int f = 0; f < 2; f++) {
+        if (f == 1) {
+            size_t gap = i;
+            while (i < len && isSpace(s[i])) i++;
+            if (i == gap) Trace_badText(i);
+        }
+        size_t start = i;
+        unsigned long x = 0;
+        while (i < len && isDigit(s[i])) x = x * 10 + (s[i++] - '0');
+        if (i == start) Trace_badText(i);
+        *fields[f] = x;
+    }
+
+    while (i < len && isSpace(s[i])) i++;
+    t->cursor = i;
+    return true;
+}
+
+/** @return number of consecutive set bits in mask starting at bit i */
+static inline unsigned runLength(uint64_t mask, unsigned i) {
+    return __builtin_ctzll(~(mask >> i));
+}
+
+/**
+ * Parses one line from the classified window at the cursor. Generic over the
+ * classifier so each SIMD flavor gets its own fully inlined copy.
+ */
+static inline __attribute__((always_inline)) bool
+Trace_nextTextWith(Trace* t, unsigned long* pid, unsigned long* vpn,
+                   CharMasks (*classify)(const char*)) {
+    if (t->mapLength - t->cursor < WINDOW_SLACK) {
+        return Trace_nextTextScalar(t, pid, vpn);
+    }
+
+    const char* p = (const char*)t->map + t->cursor;
+    CharMasks m = classify(p);
+
+    // expected layout: space* digit+ space+ digit+ space*
+    unsigned pidAt = runLength(m.spaces, 0);
+    unsigned pidLen = runLength(m.digits, pidAt);
+    unsigned gap = runLength(m.spaces, pidAt + pidLen);
+    unsigned vpnAt = pidAt + pidLen + gap;
+    unsigned vpnLen = runLength(m.digits, vpnAt);
+    unsigned end = vpnAt + vpnLen;
+
+    // anything that runs off the window, or doesn't match, is handled (or
+    // rejected) by the scalar parser
+    if (pidLen == 0 || gap == 0 || vpnLen == 0 || end >= WINDOW) {
+        return Trace_nextTextScalar(t, pid, vpn);
+    }
+
+    *pid = decodeDigits(p + pidAt, pidLen);
+    *vpn = decodeDigits(p + vpnAt, vpnLen);
+
+    unsigned tail = runLength(m.spaces, end);
+    t->cursor += end + tail;
+    if (end + tail >= WINDOW) { // long run of blank lines, finish it off
+        while (t->cursor < t->mapLength
+               && isSpace(((const char*)t->map)[t->cursor])) {
+            t->cursor++;
+        }
+    }
+    return true;
+}
+
+static bool Trace_nextText_scalar(Trace* t, unsigned long* pid,
+                                  unsigned long* vpn) {
+    return Trace_nextTextWith(t, pid, vpn, classify_scalar);
+}
+
+#ifdef TRACE_HAVE_X86_SIMD
+__attribute__((target("sse4.2"))) static bool
+Trace_nextText_sse42(Trace* t, unsigned long* pid, unsigned long* vpn) {
+    return Trace_nextTextWith(t, pid, vpn, classify_sse42);
+}
+
+__attribute__((target("avx2"))) static bool
+Trace_nextText_avx2(Trace* t, unsigned long* pid, unsigned long* vpn) {
+    return Trace_nextTextWith(t, pid, vpn, classify_avx2);
+}
+#endif
+
+/** Picks the widest text parser this CPU can run */
+static void Trace_pickTextParser(Trace* t) {
+    t->nextText = Trace_nextText_scalar;
+#ifdef TRACE_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        t->nextText = Trace_nextText_avx2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        t->nextText = Trace_nextText_sse42;
+    }
+#endif
+}
+
+// === OPENING AND MAPPING ===
+
+/** Maps the whole file read-only; empty files get an empty mapping */
+static void Trace_map(Trace* t, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("Error reading size of trace file.");
+        exit(EXIT_FAILURE);
+    }
+
+    t->mapLength = st.st_size;
+    if (t->mapLength == 0) {
+        t->map = NULL;
+        return;
+    }
+    t->map = mmap(NULL, t->mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (t->map == MAP_FAILED) {
+        perror("Error mapping trace file into memory.");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/** Validates the header of a mapped binary trace */
+static void Trace_checkBinary(Trace* t, const char* filename) {
+    if (t->mapLength < sizeof(TraceHeader)) {
+        fprintf(stderr, "ERROR: binary trace %s is truncated\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    const TraceHeader* h = t->map;
+    if (h->version != TRACE_VERSION || h->recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr,
+                "ERROR: binary trace %s has version %u (record size %u), "
+                "expected version %u (record size %zu). Reconvert it with "
+                "pfsim-convert.\n",
+                filename, h->version, h->recordSize, TRACE_VERSION,
+                sizeof(TraceRecord));
+        exit(EXIT_FAILURE);
+    }
+    if (h->numRecords
+        > (t->mapLength - sizeof(TraceHeader)) / sizeof(TraceRecord)) {
+        fprintf(stderr, "ERROR: binary trace %s is truncated\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    t->records = (const TraceRecord*)((const char*)t->map
+                                      + sizeof(TraceHeader));
+    t->numRecords = h->numRecords;
+}
+
+/**
+ * Opens a trace file, detecting its format from the first bytes.
+ * @param filename path to the trace
+ * @return trace positioned at the first reference, or exits with an error
+ */
+Trace* Trace_open(const char* filename) {
+    assert(filename != NULL);
+
+    Trace* t = calloc(1, sizeof(Trace));
+    if (t == NULL) {
+        perror("Couldn't allocate memory for trace reader.");
+        exit(EXIT_FAILURE);
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "ERROR: error opening specified trace file\n");
+        exit(EXIT_FAILURE);
+    }
+    Trace_map(t, fd);
+    close(fd); // mapping stays valid
+
+    if (t->mapLength >= TRACE_MAGIC_LEN
+        && memcmp(t->map, TRACE_MAGIC, TRACE_MAGIC_LEN) == 0) {
+        t->format = TRACE_BINARY;
+        Trace_checkBinary(t, filename);
+    } else {
+        t->format = TRACE_TEXT;
+        Trace_pickTextParser(t);
+    }
+
+    t->cursor = 0;
+    Trace_adviseSequential(t, true);
+    return t;
+}
+
+/**
+ * Closes a trace and releases its mapping.
+ */
+void Trace_close(Trace* t) {
+    if (t == NULL) return;
+    if (t->map != NULL) munmap((void*)t->map, t->mapLength);
+    free(t);
+}
+
+/**
+ * Tells the kernel whether the trace will be read front to back (first pass)
+ * or with seeks (simulation), which sets how aggressively it reads ahead.
+ */
+void Trace_adviseSequential(Trace* t, bool sequential) {
+    if (t->map == NULL) return;
+    int advice = sequential ? MADV_SEQUENTIAL : MADV_NORMAL;
+    if (madvise((void*)t->map, t->mapLength, advice) != 0) {
+        perror("WARN: madvise on trace file failed");
+    }
+}
+
+/**
+ * Reads the reference at the current position and advances past it.
+ * @param[out] pid process id of the reference
+ * @param[out] vpn virtual page number of the reference
+ * @return true if a reference was read, false at the end of the trace
+ */
+bool Trace_next(Trace* t, unsigned long* pid, unsigned long* vpn) {
+    if (t->format == TRACE_BINARY) {
+        if (t->cursor >= t->numRecords) return false;
+        *pid = t->records[t->cursor].pid;
+        *vpn = t->records[t->cursor].vpn;
+        t->cursor++;
+        return true;
+    }
+    return t->nextText(t, pid, vpn);
+}
+
+/**
+ * @return the position of the next reference, see file comment for units
+ */
+long Trace_tell(Trace* t) { return (long)t->cursor; }
+
+/**
+ * Moves to a position previously returned by Trace_tell.
+ */
+void Trace_seek(Trace* t, long pos) {
+    assert(pos >= 0);
+    assert(t->format == TRACE_TEXT || (size_t)pos <= t->numRecords);
+    assert(t->format == TRACE_BINARY || (size_t)pos <= t->mapLength);
+    t->cursor = pos;
+}
+
+/** Moves back to the first reference */
+void Trace_rewind(Trace* t) { Trace_seek(t, 0); }
+
+/**
+ * Cuts the trace into roughly equal pieces that start on line (or record)
+ * boundaries, for scanning in parallel.
+ * @param n desired number of pieces
+ * @param[out] bounds n + 1 positions
+ * @return number of pieces actually made, fewer than n for tiny traces
+ */
+size_t Trace_split(const Trace* t, size_t n, long* bounds) {
+    assert(n > 0);
+    size_t total = t->format == TRACE_BINARY ? t->numRecords : t->mapLength;
+    const char* text = t->map;
+
+    size_t made = 0;
+    bounds[0] = 0;
+    for (size_t i = 1; i < n; i++) {
+        size_t cut = total / n * i;
+        if (t->format == TRACE_TEXT) {
+            // land where Trace_tell would after reading the line cut through:
+            // past its newline and any whitespace after it
+            const char* nl = memchr(text + cut, '\n', total - cut);
+            cut = nl == NULL ? total : (size_t)(nl - text);
+            while (cut < total && isSpace(text[cut])) cut++;
+        }
+        if ((long)cut > bounds[made] && cut < total) bounds[++made] = cut;
+    }
+    bounds[++made] = total;
+    return made;
+}
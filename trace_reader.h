@@ -0,0 +1,113 @@
+/**
+ * CS 537 Programming Assignment 4 (Fall 2020)
+ * @file trace_reader.h
+ * @brief Reads memory references out of a trace file, in either the plain
+ * text .addrtrace format or the packed binary format made by pfsim-convert.
+ * Either way the file is memory mapped and read in place.
+ * @details Positions handed out by Trace_tell and accepted by Trace_seek are
+ * opaque to callers: byte offsets for text traces, record indices for binary
+ * traces. Both grow monotonically through the file, so they can be compared
+ * to order processes.
+ */
+
+#ifndef _TRACE_READER_
+#define _TRACE_READER_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// "PFSIMBTR", written at the start of every binary trace
+#define TRACE_MAGIC "PFSIMBTR"
+#define TRACE_MAGIC_LEN 8
+#define TRACE_VERSION 1
+
+typedef enum TraceFormat {
+    TRACE_TEXT = 0,   // "pid vpn\n" lines, parsed in place
+    TRACE_BINARY = 1, // TraceHeader + TraceRecord[], indexed in place
+} TraceFormat;
+
+// Header of a binary trace file, followed directly by numRecords records
+typedef struct trace_header_t {
+    char magic[TRACE_MAGIC_LEN];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(TraceRecord), guards against layout changes
+    uint64_t numRecords;
+} TraceHeader;
+
+// One memory reference, packed so a record is 12 bytes on disk
+typedef struct __attribute__((packed)) trace_record_t {
+    uint32_t pid;
+    uint64_t vpn;
+} TraceRecord;
+
+typedef struct trace_t {
+    TraceFormat format;
+    const void* map;  // whole file, mapped read-only
+    size_t mapLength; // bytes mapped
+    size_t cursor;    // byte offset (text) or record index (binary) of the
+                      // reference the next read returns
+
+    // TRACE_TEXT: parser for this CPU (scalar, SSE4.2 or AVX2)
+    bool (*nextText)(struct trace_t* t, unsigned long* pid,
+                     unsigned long* vpn);
+
+    // TRACE_BINARY
+    const TraceRecord* records; // first record, just past the header
+    size_t numRecords;
+} Trace;
+
+/**
+ * Opens a trace file, detecting its format from the first bytes.
+ * @param filename path to the trace
+ * @return trace positioned at the first reference, or exits with an error
+ */
+Trace* Trace_open(const char* filename);
+
+/**
+ * Closes a trace and releases its mapping.
+ */
+void Trace_close(Trace* t);
+
+/**
+ * Tells the kernel whether the trace will be read front to back (first pass)
+ * or with seeks (simulation), which sets how aggressively it reads ahead.
+ */
+void Trace_adviseSequential(Trace* t, bool sequential);
+
+/**
+ * Reads the reference at the current position and advances past it.
+ * @param[out] pid process id of the reference
+ * @param[out] vpn virtual page number of the reference
+ * @return true if a reference was read, false at the end of the trace
+ */
+bool Trace_next(Trace* t, unsigned long* pid, unsigned long* vpn);
+
+/**
+ * @return the position of the next reference, see file comment for units
+ */
+long Trace_tell(Trace* t);
+
+/**
+ * Moves to a position previously returned by Trace_tell.
+ */
+void Trace_seek(Trace* t, long pos);
+
+/** Moves back to the first reference */
+void Trace_rewind(Trace* t);
+
+/**
+ * Cuts the trace into roughly equal pieces that start on line (or record)
+ * boundaries, for scanning in parallel. Piece i covers positions
+ * [bounds[i], bounds[i + 1]). A copy of the Trace struct seeked to bounds[i]
+ * reads exactly that piece; copies share the mapping and can be read from
+ * different threads.
+ * @details Text traces are cut just after a newline, so this assumes one
+ * reference per line, as the .addrtrace format specifies.
+ * @param n desired number of pieces
+ * @param[out] bounds n + 1 positions
+ * @return number of pieces actually made, fewer than n for tiny traces
+ */
+size_t Trace_split(const Trace* t, size_t n, long* bounds);
+
+#endif